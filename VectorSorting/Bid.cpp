@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <functional>
+#include <iostream>
+#include "Bid.hpp"
+#include "BidSnapshot.hpp"
+#include "CSVparser.hpp"
+
+using namespace std;
+
+StringPool bidStrings;
+Dictionary bidDepartments;
+Dictionary bidFunds;
+
+/**
+ * Default constructor
+ */
+Bid::Bid()
+    : bidId(MISSING), title(0), department(0), fund(0), inventoryID(0), vehicleID(0),
+      receiptNumber(0), closeDate(NO_DATE), amount(0), ccFee(0), auctionFee(0), expenses(0),
+      netSales(0), inventoryKey(MISSING),
+      vehicleKey(MISSING), receiptKey(UINT64_MAX) {
+}
+
+/**
+ * Get the text of a string handle
+ *
+ * @param handle handle returned by bidStrings.intern
+ */
+string_view text(uint32_t handle) {
+    return bidStrings.view(handle);
+}
+
+/**
+ * Format a close date for display
+ *
+ * @param closeDate days since 1970-01-01, or Bid::NO_DATE
+ */
+string dateText(int32_t closeDate) {
+    if (closeDate == Bid::NO_DATE) {
+        return string();
+    }
+    return csv::formatDate(closeDate);
+}
+
+/**
+ * Format an amount of cents for display ("-1234.05")
+ *
+ * @param cents the amount
+ */
+string centsText(int64_t cents) {
+    uint64_t magnitude = cents < 0 ? 0 - static_cast<uint64_t>(cents) : static_cast<uint64_t>(cents);
+    string fraction = to_string(magnitude % 100);
+    return (cents < 0 ? "-" : "") + to_string(magnitude / 100) + (fraction.size() < 2 ? ".0" : ".") + fraction;
+}
+
+/**
+ * Reduce a header name to lower case letters and digits, so
+ * "Auction Title " and "AuctionTitle" compare equal
+ */
+static string normalize(const string& name) {
+    string result;
+    for (char c : name) {
+        if (isalnum(static_cast<unsigned char>(c))) {
+            result += static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        }
+    }
+    return result;
+}
+
+/**
+ * Find the column holding a bid field by any of its known names
+ *
+ * @param schema header of the CSV file
+ * @param names normalized names the column goes by
+ * @param fallback position to use when none of the names is present
+ */
+static unsigned int findColumn(const csv::Schema& schema, const vector<string>& names, unsigned int fallback) {
+    for (unsigned int i = 0; i < schema.size(); ++i) {
+        if (find(names.begin(), names.end(), normalize(schema.name(i))) != names.end()) {
+            return i;
+        }
+    }
+    return fallback;
+}
+
+/**
+ * Find a column every bid needs, which must fall inside the header
+ *
+ * @param schema header of the CSV file
+ * @param names normalized names the column goes by
+ * @param fallback position to use when none of the names is present
+ * @param label name of the column for the error
+ * @throw csv::Error if the header is too short to hold the column
+ */
+static unsigned int requireColumn(const csv::Schema& schema, const vector<string>& names,
+                                  unsigned int fallback, const string& label) {
+    unsigned int column = findColumn(schema, names, fallback);
+    if (column >= schema.size()) {
+        throw csv::Error(string("No ").append(label).append(" column"));
+    }
+    return column;
+}
+
+/**
+ * Resolve the bid columns from the header. The monthly export
+ * ("Auction Title", ..., "Decal /Vehicle ID", ...) and the Dec 2016
+ * extract ("ArticleTitle", ...) name and order them differently.
+ *
+ * @throw csv::Error if a column every bid needs is missing
+ */
+BidColumns resolveColumns(const csv::Schema& schema) {
+    BidColumns columns;
+    columns.title = requireColumn(schema, { "articletitle", "auctiontitle" }, 0, "Auction Title");
+    columns.bidId = requireColumn(schema, { "articleid", "auctionid" }, 1, "Auction ID");
+    columns.department = requireColumn(schema, { "department" }, 2, "Department");
+    columns.closeDate = requireColumn(schema, { "closedate" }, 3, "Close Date");
+    columns.amount = requireColumn(schema, { "winningbid" }, 4, "Winning Bid");
+    columns.inventoryID = requireColumn(schema, { "inventoryid" }, 5, "Inventory ID");
+    columns.vehicleID = requireColumn(schema, { "vehicleid", "decalvehicleid" }, 6, "Vehicle ID");
+    columns.receiptNumber = requireColumn(schema, { "receiptnumber" }, 7, "Receipt Number");
+    columns.fund = requireColumn(schema, { "fund" }, 8, "Fund");
+    // only the monthly export has these
+    columns.ccFee = findColumn(schema, { "ccfee" }, BidColumns::NONE);
+    columns.auctionFee = findColumn(schema, { "auctionfeetotal" }, BidColumns::NONE);
+    columns.expenses = findColumn(schema, { "expenses" }, BidColumns::NONE);
+    columns.netSales = findColumn(schema, { "netsales" }, BidColumns::NONE);
+
+    // records shorter than this are skipped rather than read past their end
+    columns.fields = 0;
+    for (unsigned int column : { columns.title, columns.bidId, columns.department, columns.closeDate,
+                                 columns.amount, columns.inventoryID, columns.vehicleID,
+                                 columns.receiptNumber, columns.fund, columns.ccFee,
+                                 columns.auctionFee, columns.expenses, columns.netSales }) {
+        if (column != BidColumns::NONE) {
+            columns.fields = max(columns.fields, column + 1);
+        }
+    }
+    return columns;
+}
+
+/**
+ * Parse the leading number of a field ("75160, 75144" gives 75160)
+ *
+ * @return true if the field starts with a number that fits
+ */
+template<typename T>
+static bool leadingNumber(string_view value, T& out) {
+    while (!value.empty() && value.front() == ' ') {
+        value.remove_prefix(1);
+    }
+    from_chars_result r = from_chars(value.data(), value.data() + value.size(), out);
+    return r.ec == errc();
+}
+
+/**
+ * Parse a currency column that may be missing from the file, leaving
+ * out at 0 when it is missing or empty
+ */
+static void optionalCents(const vector<string_view>& row, unsigned int column, int64_t& out) {
+    long long cents;
+    if (column != BidColumns::NONE && csv::toCents(row[column], cents) == errc()) {
+        out = cents;
+    }
+}
+
+/**
+ * Parse the numeric fields and sort keys of one CSV record. Text fields
+ * are left empty, nothing is added to the string pool or dictionaries.
+ *
+ * @param row fields of the record, at least columns.fields of them
+ * @param columns positions of the bid fields
+ */
+Bid parseBidNumbers(const vector<string_view>& row, const BidColumns& columns) {
+    Bid bid;
+    long long number;
+    int date;
+
+    if (csv::toInteger(row[columns.bidId], number) == errc() && number >= 0 && number < Bid::MISSING) {
+        bid.bidId = static_cast<uint32_t>(number);
+    }
+    if (csv::toDate(row[columns.closeDate], date) == errc()) {
+        bid.closeDate = date;
+    }
+    if (csv::toCents(row[columns.amount], number) == errc()) {
+        bid.amount = number;
+    }
+    if (!leadingNumber(row[columns.inventoryID], bid.inventoryKey)) {
+        bid.inventoryKey = Bid::MISSING;
+    }
+    if (!leadingNumber(row[columns.vehicleID], bid.vehicleKey)) {
+        bid.vehicleKey = Bid::MISSING;
+    }
+    if (!leadingNumber(row[columns.receiptNumber], bid.receiptKey)) {
+        bid.receiptKey = UINT64_MAX;
+    }
+    optionalCents(row, columns.ccFee, bid.ccFee);
+    optionalCents(row, columns.auctionFee, bid.auctionFee);
+    optionalCents(row, columns.expenses, bid.expenses);
+    optionalCents(row, columns.netSales, bid.netSales);
+    return bid;
+}
+
+/**
+ * Build a bid from one CSV record, parsing every sort key once
+ *
+ * @param row fields of the record, at least columns.fields of them
+ * @param columns positions of the bid fields
+ * @param batch pools for the text of the bid
+ */
+static Bid makeBid(const vector<string_view>& row, const BidColumns& columns, BidBatch& batch) {
+    Bid bid = parseBidNumbers(row, columns);
+
+    bid.title = batch.strings.intern(row[columns.title]);
+    bid.department = batch.departments.encode(row[columns.department]);
+    bid.fund = batch.funds.encode(row[columns.fund]);
+    bid.inventoryID = batch.strings.intern(row[columns.inventoryID]);
+    bid.vehicleID = batch.strings.intern(row[columns.vehicleID]);
+    bid.receiptNumber = batch.strings.intern(row[columns.receiptNumber]);
+    return bid;
+}
+
+/**
+ * Renumber the department and fund codes in string order if new values
+ * broke that order, and update the bids to match. Every container of
+ * bids holding codes has to go through here. Old codes keep their
+ * relative order, so views sorted on department or fund stay sorted.
+ *
+ * @param bids the bids whose codes to update
+ * @return true if any code changed
+ */
+bool sortDictionaries(vector<Bid>& bids) {
+    bool changed = false;
+    if (!bidDepartments.sorted()) {
+        vector<uint32_t> remap = bidDepartments.sort();
+        for (Bid& bid : bids) {
+            bid.department = remap[bid.department];
+        }
+        changed = true;
+    }
+    if (!bidFunds.sorted()) {
+        vector<uint32_t> remap = bidFunds.sort();
+        for (Bid& bid : bids) {
+            bid.fund = remap[bid.fund];
+        }
+        changed = true;
+    }
+    return changed;
+}
+
+/**
+ * Read the bids of a CSV file into a batch, from its snapshot when there
+ * is an up-to-date one. Otherwise the file is parsed and a snapshot is
+ * written for the next run.
+ *
+ * @param csvPath the path to the CSV file to read
+ * @param batch an empty batch to fill
+ * @param threads threads tokenizing each chunk, 0 for one per hardware thread
+ * @return true if the bids came from the snapshot
+ */
+bool readBids(const string& csvPath, BidBatch& batch, unsigned int threads) {
+    // a snapshot of the file as it is now skips parsing altogether
+    try {
+        if (loadSnapshot(csvPath, batch)) {
+            return true;
+        }
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+
+    // stamp the file before reading it, so a change made while it is read
+    // leaves a snapshot that no longer matches
+    SnapshotSource source;
+    bool stamped = false;
+    try {
+        stamped = snapshotSource(csvPath, source);
+    } catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+
+    // initialize the streaming CSV reader using the given path, bids are
+    // built as each chunk of the file comes in
+    csv::Reader file(csvPath, ',', 1024 * 1024, threads);
+    BidColumns columns = resolveColumns(file.getSchema());
+    vector<string_view> row;
+
+    bool complete = false;
+
+    try {
+        // loop to read rows of a CSV file
+        while (file.next(row)) {
+            // a short record has no field for some column
+            if (row.size() < columns.fields) {
+                continue;
+            }
+
+            // Create a data structure and add to the collection of bids
+            batch.bids.push_back(makeBid(row, columns, batch));
+        }
+        complete = true;
+    } catch (csv::Error &e) {
+        std::cerr << e.what() << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+
+    // snapshot only a whole file, for the next run to start from
+    if (complete && stamped) {
+        try {
+            saveSnapshot(csvPath, source, batch);
+        } catch (std::exception& e) {
+            std::cerr << "Snapshot not saved: " << e.what() << std::endl;
+        }
+    }
+    return false;
+}
+
+/**
+ * Append the bids of a batch to a table. Their text moves into bidStrings
+ * and the global dictionaries; call sortDictionaries afterwards.
+ *
+ * @param bids the table
+ * @param batch bids read by readBids
+ * @param keep tells which bids to append, nullptr appends all of them
+ * @return the number of bids appended
+ */
+size_t appendBids(vector<Bid>& bids, const BidBatch& batch, const function<bool(const Bid&)>& keep) {
+    vector<uint32_t> handles(batch.strings.size());
+    for (uint32_t i = 0; i < handles.size(); ++i) {
+        handles[i] = bidStrings.intern(batch.strings.view(i));
+    }
+    vector<uint32_t> departments(batch.departments.size());
+    for (uint32_t i = 0; i < departments.size(); ++i) {
+        departments[i] = bidDepartments.encode(batch.departments.decode(i));
+    }
+    vector<uint32_t> funds(batch.funds.size());
+    for (uint32_t i = 0; i < funds.size(); ++i) {
+        funds[i] = bidFunds.encode(batch.funds.decode(i));
+    }
+
+    size_t first = bids.size();
+    bids.reserve(first + batch.bids.size());
+    for (const Bid& read : batch.bids) {
+        if (keep && !keep(read)) {
+            continue;
+        }
+        Bid bid = read;
+        bid.title = handles[bid.title];
+        bid.inventoryID = handles[bid.inventoryID];
+        bid.vehicleID = handles[bid.vehicleID];
+        bid.receiptNumber = handles[bid.receiptNumber];
+        bid.department = departments[bid.department];
+        bid.fund = funds[bid.fund];
+        bids.push_back(bid);
+    }
+    return bids.size() - first;
+}
@@ -0,0 +1,91 @@
+#ifndef     _BID_HPP_
+# define    _BID_HPP_
+
+# include <climits>
+# include <cstdint>
+# include <functional>
+# include <string>
+# include <string_view>
+# include <type_traits>
+# include <vector>
+# include "CSVparser.hpp"
+# include "Dictionary.hpp"
+# include "StringPool.hpp"
+
+// Compact bid record. Numbers and dates are parsed once at load time so sorts
+// compare plain integers; text columns are handles into bidStrings, except
+// department and fund, which are codes of the bidDepartments / bidFunds
+// dictionaries.
+struct Bid {
+    static constexpr uint32_t MISSING = 0xFFFFFFFF;     // numeric key absent or not a number
+    static constexpr int32_t NO_DATE = INT32_MIN;       // close date absent or not a date
+
+    uint32_t bidId;             // unique identifier (Auction ID)
+    uint32_t title;
+    uint32_t department;        // dictionary code, ordered like the text
+    uint32_t fund;              // dictionary code, ordered like the text
+    uint32_t inventoryID;       // original text, may list several IDs
+    uint32_t vehicleID;
+    uint32_t receiptNumber;
+    int32_t closeDate;          // days since 1970-01-01
+    int64_t amount;             // winning bid in cents
+    int64_t ccFee;              // fees, expenses and net sales in cents,
+    int64_t auctionFee;         // 0 when the file has no such column
+    int64_t expenses;
+    int64_t netSales;
+    uint32_t inventoryKey;      // first inventory number, for sorting
+    uint32_t vehicleKey;
+    uint64_t receiptKey;        // receipt numbers don't fit 32 bits
+
+    Bid();
+};
+
+// Bids hold no owning members: copying or swapping one is a flat memory copy
+// and never allocates.
+static_assert(std::is_trivially_copyable<Bid>::value, "Bid must stay trivially copyable");
+
+// Column positions of the bid fields in a CSV file
+struct BidColumns {
+    static constexpr unsigned int NONE = UINT_MAX;     // optional column not in the file
+
+    unsigned int title;
+    unsigned int bidId;
+    unsigned int department;
+    unsigned int closeDate;
+    unsigned int amount;
+    unsigned int inventoryID;
+    unsigned int vehicleID;
+    unsigned int receiptNumber;
+    unsigned int fund;
+    unsigned int ccFee;
+    unsigned int auctionFee;
+    unsigned int expenses;
+    unsigned int netSales;
+    unsigned int fields;                               // fields a record needs to hold every column
+};
+
+// Strings shared by every loaded bid
+extern StringPool bidStrings;
+extern Dictionary bidDepartments;
+extern Dictionary bidFunds;
+
+// Bids of one CSV file holding handles and codes of pools of their own, so
+// several files can be read at once; appendBids moves them into the table
+struct BidBatch {
+    std::vector<Bid> bids;
+    StringPool strings;
+    Dictionary departments;
+    Dictionary funds;
+};
+
+std::string_view text(uint32_t handle);
+std::string dateText(int32_t closeDate);
+std::string centsText(int64_t cents);
+BidColumns resolveColumns(const csv::Schema& schema);
+Bid parseBidNumbers(const std::vector<std::string_view>& row, const BidColumns& columns);
+bool sortDictionaries(std::vector<Bid>& bids);
+bool readBids(const std::string& csvPath, BidBatch& batch, unsigned int threads = 0);
+size_t appendBids(std::vector<Bid>& bids, const BidBatch& batch,
+                  const std::function<bool(const Bid&)>& keep = nullptr);
+
+#endif /*!_BID_HPP_*/
@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <limits>
+#include "BidAggregate.hpp"
+
+using namespace std;
+
+// Below this many rows per thread the report is totalled on one thread
+static const size_t AGGREGATE_MIN_SLICE = 16 * 1024;
+
+// Open-addressing hash table from group key to totals. Probing only walks
+// the slot array of (key, index) pairs; the totals sit in a dense array in
+// insertion order.
+class GroupTable {
+  public:
+    GroupTable()
+        : _slots(16, Slot{ 0, EMPTY }), _mask(15) {
+    }
+
+    // totals of a group, created empty on first use
+    GroupTotals& find(uint32_t key) {
+        size_t slot = hash(key) & _mask;
+        while (_slots[slot].index != EMPTY) {
+            if (_slots[slot].key == key) {
+                return _groups[_slots[slot].index];
+            }
+            slot = (slot + 1) & _mask;
+        }
+
+        _slots[slot].key = key;
+        _slots[slot].index = static_cast<uint32_t>(_groups.size());
+        _groups.push_back(emptyTotals(key));
+        // keep the load factor at or below one half
+        if (_groups.size() * 2 > _slots.size()) {
+            grow();
+        }
+        return _groups.back();
+    }
+
+    vector<GroupTotals>& groups() {
+        return _groups;
+    }
+
+  private:
+    struct Slot {
+        uint32_t key;
+        uint32_t index;
+    };
+
+    static constexpr uint32_t EMPTY = 0xFFFFFFFF;
+
+    static size_t hash(uint32_t key) {
+        // multiplicative hashing, the high bits mix every bit of the key
+        return static_cast<size_t>((static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    static GroupTotals emptyTotals(uint32_t key) {
+        GroupTotals totals;
+        totals.key = key;
+        totals.count = 0;
+        for (int m = 0; m < MEASURES; ++m) {
+            totals.sum[m] = 0;
+            totals.min[m] = numeric_limits<int64_t>::max();
+            totals.max[m] = numeric_limits<int64_t>::min();
+        }
+        return totals;
+    }
+
+    void grow() {
+        vector<Slot> slots(_slots.size() * 2, Slot{ 0, EMPTY });
+        _mask = slots.size() - 1;
+        for (uint32_t index = 0; index < _groups.size(); ++index) {
+            size_t slot = hash(_groups[index].key) & _mask;
+            while (slots[slot].index != EMPTY) {
+                slot = (slot + 1) & _mask;
+            }
+            slots[slot].key = _groups[index].key;
+            slots[slot].index = index;
+        }
+        _slots.swap(slots);
+    }
+
+    vector<Slot> _slots;
+    size_t _mask;
+    vector<GroupTotals> _groups;
+};
+
+/**
+ * Average of a measure over the group, in cents
+ */
+double GroupTotals::average(Measure measure) const {
+    return count == 0 ? 0.0 : static_cast<double>(sum[measure]) / static_cast<double>(count);
+}
+
+/**
+ * Group key of one row
+ */
+static uint32_t groupKey(const BidColumnStore& columns, GroupBy group, size_t row) {
+    switch (group) {
+    case eGROUP_DEPARTMENT:
+        return columns.department[row];
+    case eGROUP_FUND:
+        return columns.fund[row];
+    default:
+        {
+            int32_t days = columns.closeDate[row];
+            if (days == Bid::NO_DATE) {
+                return GroupTotals::NO_GROUP;
+            }
+            int year, month, day;
+            csv::civilDate(days, year, month, day);
+            return static_cast<uint32_t>(year * 12 + month - 1);
+        }
+    }
+}
+
+/**
+ * Total rows [begin, end) into a table
+ */
+static void aggregateSlice(const BidColumnStore& columns, GroupBy group, size_t begin, size_t end,
+                           GroupTable& table) {
+    const int64_t* measures[MEASURES] = {
+        columns.amount.data(), columns.ccFee.data(), columns.auctionFee.data(),
+        columns.expenses.data(), columns.netSales.data()
+    };
+
+    for (size_t row = begin; row < end; ++row) {
+        GroupTotals& totals = table.find(groupKey(columns, group, row));
+        totals.count++;
+        for (int m = 0; m < MEASURES; ++m) {
+            int64_t value = measures[m][row];
+            totals.sum[m] += value;
+            totals.min[m] = min(totals.min[m], value);
+            totals.max[m] = max(totals.max[m], value);
+        }
+    }
+}
+
+/**
+ * Count, sum, min and max every measure per group
+ *
+ * @param columns the bid table as columns
+ * @param group what to group by
+ * @param pool threads to total with, or nullptr for this thread only
+ * @return one entry per group, in key order
+ */
+vector<GroupTotals> aggregate(const BidColumnStore& columns, GroupBy group, ThreadPool* pool) {
+    size_t rows = columns.size();
+    size_t slices = 1;
+    if (pool != nullptr) {
+        slices = max<size_t>(1, min<size_t>(pool->size(), rows / AGGREGATE_MIN_SLICE));
+    }
+
+    // one partial table per slice, merged below
+    vector<GroupTable> partials(slices);
+    if (slices == 1) {
+        aggregateSlice(columns, group, 0, rows, partials[0]);
+    } else {
+        pool->run(slices, [&](size_t i) {
+            aggregateSlice(columns, group, rows * i / slices, rows * (i + 1) / slices, partials[i]);
+        });
+    }
+
+    GroupTable& table = partials[0];
+    for (size_t i = 1; i < slices; ++i) {
+        for (const GroupTotals& partial : partials[i].groups()) {
+            GroupTotals& totals = table.find(partial.key);
+            totals.count += partial.count;
+            for (int m = 0; m < MEASURES; ++m) {
+                totals.sum[m] += partial.sum[m];
+                totals.min[m] = min(totals.min[m], partial.min[m]);
+                totals.max[m] = max(totals.max[m], partial.max[m]);
+            }
+        }
+    }
+
+    vector<GroupTotals> groups = std::move(table.groups());
+    sort(groups.begin(), groups.end(), [](const GroupTotals& a, const GroupTotals& b) { return a.key < b.key; });
+    return groups;
+}
+
+/**
+ * Display name of a group
+ *
+ * @param group what the report is grouped by
+ * @param key the group's key
+ */
+string groupName(GroupBy group, uint32_t key) {
+    // code 0 of both dictionaries is the empty text
+    switch (group) {
+    case eGROUP_DEPARTMENT:
+        return key == 0 ? "(no department)" : string(bidDepartments.decode(key));
+    case eGROUP_FUND:
+        return key == 0 ? "(no fund)" : string(bidFunds.decode(key));
+    default:
+        if (key == GroupTotals::NO_GROUP) {
+            return "(no close date)";
+        }
+        {
+            string month = to_string(key % 12 + 1);
+            return to_string(key / 12) + (month.size() < 2 ? "-0" : "-") + month;
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef     _BIDAGGREGATE_HPP_
+# define    _BIDAGGREGATE_HPP_
+
+# include <cstdint>
+# include <string>
+# include <vector>
+# include "BidFilter.hpp"
+# include "ThreadPool.hpp"
+
+// What a sales report groups the bids by
+enum GroupBy
+{
+    eGROUP_DEPARTMENT,
+    eGROUP_FUND,
+    eGROUP_CLOSE_MONTH
+};
+
+// Monetary columns a sales report totals
+enum Measure
+{
+    eWINNING_BID,
+    eCC_FEE,
+    eAUCTION_FEE,
+    eEXPENSES,
+    eNET_SALES,
+    MEASURES
+};
+
+// Count, sum, min and max of every measure over one group, in cents
+struct GroupTotals {
+    static constexpr uint32_t NO_GROUP = 0xFFFFFFFF;   // close month of bids without a close date
+
+    uint32_t key;               // department or fund code, or year * 12 + month - 1
+    uint64_t count;
+    int64_t sum[MEASURES];
+    int64_t min[MEASURES];
+    int64_t max[MEASURES];
+
+    double average(Measure measure) const;
+};
+
+// Hash group-by over the column store. Each thread of the pool totals a
+// slice of the rows in its own open-addressing table and the partial
+// tables are merged at the end. Groups come back in key order: names for
+// department and fund, chronological for months.
+std::vector<GroupTotals> aggregate(const BidColumnStore& columns, GroupBy group, ThreadPool* pool = nullptr);
+std::string groupName(GroupBy group, uint32_t key);
+
+#endif /*!_BIDAGGREGATE_HPP_*/
@@ -0,0 +1,620 @@
+//============================================================================
+// Name        : BidBench.cpp
+// Description : Benchmarks of the bid load, sort and filter paths
+//============================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Bid.hpp"
+#include "BidFilter.hpp"
+#include "BidSnapshot.hpp"
+#include "BidSort.hpp"
+#include "CSVparser.hpp"
+#include "ThreadPool.hpp"
+
+using namespace std;
+
+//============================================================================
+// Global definitions visible to all methods and classes
+//============================================================================
+
+// Rows of the generated files unless --rows says otherwise
+static const size_t BENCH_ROWS[] = { 10000, 1000000, 10000000 };
+
+// Seed of the generated files, so every run times the same data
+static const uint64_t BENCH_SEED = 20161231;
+
+// Version of the JSON layout, raised when fields change meaning
+static const int BENCH_FORMAT = 1;
+
+// Settings from the command line
+struct BenchOptions {
+    vector<size_t> rows;
+    unsigned int warmup = 1;
+    unsigned int repetitions = 5;
+    unsigned int threads = 0;       // 0 = one per hardware thread
+    string dir;
+    string out;                     // empty writes the JSON to std::cout
+    vector<string> checkFiles;      // non-empty checks the tokenizers instead
+};
+
+// Wall-clock samples of one benchmark, in seconds
+struct BenchResult {
+    string name;
+    size_t rows;
+    vector<double> samples;
+};
+
+// Results are kept here so the compiler can't drop the work being timed
+static volatile size_t sink = 0;
+
+// Column names of the sort keys, indexed by SortKey - 1
+static const char* const KEY_NAMES[] = {
+    "title", "auction_id", "department", "close_date", "winning_bid",
+    "inventory_id", "vehicle_id", "receipt_number", "fund"
+};
+
+// Header of the eBid monthly sales export
+static const char* const CSV_HEADER =
+    "Auction Title ,Auction ID,Department ,Close Date ,Winning Bid ,CC Fee,Fee Percent,"
+    "Auction Fee Subtotal,Auction Fee Total,Pay Status ,Paid Date ,Asset #,Inventory ID,"
+    "Decal /Vehicle ID,VTR Number,Receipt Number ,Cap,Expenses,Net Sales,Fund,Business Unit";
+
+static const char* const TITLE_WORDS[] = {
+    "Dell", "HP", "Ford", "Chevrolet", "Laptop", "Desktop", "Monitor", "Printer",
+    "Sedan", "Pickup", "Truck", "Desk", "Chair", "Cabinet", "Lot of", "Assorted",
+    "Office", "Police", "Tools", "Mower", "Bicycle", "Camera", "Radio", "Trailer"
+};
+
+static const char* const DEPARTMENTS[] = {
+    "ITS", "Fleet", "Police", "Fire", "Parks", "Public Works", "Library", "Finance",
+    "Water", "Solid Waste", "Transportation", "Health"
+};
+
+static const char* const FUNDS[] = {
+    "General Fund", "Enterprise", "Grant Funds", "Capital Projects", "Special Revenue",
+    "Internal Service"
+};
+
+//============================================================================
+// Synthetic data
+//============================================================================
+
+/**
+ * Dollar text the way the eBid export writes it, e.g. "$3,000.50 "
+ *
+ * @param cents the amount in cents
+ */
+static string dollars(int64_t cents) {
+    string digits = to_string(cents / 100);
+    string text = "$";
+    for (size_t i = 0; i < digits.size(); ++i) {
+        if (i > 0 && (digits.size() - i) % 3 == 0) {
+            text += ',';
+        }
+        text += digits[i];
+    }
+    char fraction[8];
+    snprintf(fraction, sizeof(fraction), ".%02d ", static_cast<int>(cents % 100));
+    return text + fraction;
+}
+
+/**
+ * Write a CSV file of rows made-up bids shaped like the eBid export. The
+ * same row count always gives the same file. It is written under another
+ * name first, so an interrupted run never leaves a short file behind.
+ *
+ * @param path the file to write
+ * @param rows the number of bids
+ */
+static void generateBids(const string& path, size_t rows) {
+    mt19937_64 random(BENCH_SEED + rows);
+    auto pick = [&random](size_t count) { return static_cast<size_t>(random() % count); };
+
+    // Auction IDs are unique but not in file order, so sorting them is work
+    vector<uint32_t> ids(rows);
+    iota(ids.begin(), ids.end(), 100000u);
+    shuffle(ids.begin(), ids.end(), random);
+
+    int firstDay = 0;
+    csv::toDate("1/1/2010", firstDay);
+
+    string temp = path + ".tmp";
+    ofstream out(temp, ios::binary | ios::trunc);
+    if (!out) {
+        throw runtime_error("Failed to create " + temp);
+    }
+
+    const size_t words = sizeof(TITLE_WORDS) / sizeof(TITLE_WORDS[0]);
+    string buffer = CSV_HEADER;
+    buffer += '\n';
+    vector<string> row(21);
+    for (size_t i = 0; i < rows; ++i) {
+        string title = string(TITLE_WORDS[pick(words)]) + " " + TITLE_WORDS[pick(words)];
+        if (pick(3) == 0) {
+            title += string(" ") + TITLE_WORDS[pick(words)];
+        }
+        if (pick(20) == 0) {
+            title += ", " + to_string(pick(50) + 2) + " pcs";
+        }
+        int64_t amount = 100 + static_cast<int64_t>(pick(pick(4) == 0 ? 5000000 : 50000));
+        int64_t ccFee = amount * 23 / 1000;
+        int64_t auctionFee = amount / 10;
+        int64_t expenses = pick(10) == 0 ? static_cast<int64_t>(pick(20000)) : 0;
+        int closeDate = firstDay + static_cast<int>(pick(3650));
+
+        string inventory = to_string(10000 + pick(90000));
+        if (pick(10) == 0) {
+            for (size_t extra = pick(3) + 1; extra > 0; --extra) {
+                inventory += ", " + to_string(10000 + pick(90000));
+            }
+        }
+
+        row[0] = title;
+        row[1] = to_string(ids[i]);
+        row[2] = DEPARTMENTS[pick(sizeof(DEPARTMENTS) / sizeof(DEPARTMENTS[0]))];
+        row[3] = csv::formatDate(closeDate);
+        row[4] = dollars(amount);
+        row[5] = dollars(ccFee);
+        row[6] = "0.23";
+        row[7] = dollars(auctionFee);
+        row[8] = dollars(auctionFee);
+        row[9] = "Successful";
+        row[10] = csv::formatDate(closeDate + 3 + static_cast<int>(pick(30)));
+        row[11] = "";
+        row[12] = inventory;
+        row[13] = pick(5) == 0 ? to_string(1000 + pick(9000)) : "";
+        row[14] = "";
+        row[15] = to_string(3600000000ull + pick(400000000));
+        row[16] = "$3,000 ";
+        row[17] = dollars(expenses);
+        row[18] = dollars(amount - ccFee - auctionFee - expenses);
+        row[19] = FUNDS[pick(sizeof(FUNDS) / sizeof(FUNDS[0]))];
+        row[20] = "0";
+
+        for (size_t column = 0; column < row.size(); ++column) {
+            if (column > 0) {
+                buffer += ',';
+            }
+            csv::writeField(buffer, row[column]);
+        }
+        buffer += '\n';
+        if (buffer.size() >= 1024 * 1024) {
+            out.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+    out.write(buffer.data(), buffer.size());
+    out.close();
+    if (!out) {
+        throw runtime_error("Failed to write " + temp);
+    }
+    filesystem::rename(temp, path);
+}
+
+//============================================================================
+// Timing and statistics
+//============================================================================
+
+/**
+ * Time a benchmark on the wall clock: warmup runs first, then the timed
+ * repetitions
+ *
+ * @param name the benchmark name in the report
+ * @param rows the size of the table it runs on
+ * @param options warmup and repetition counts
+ * @param run the work to time
+ * @param prepare untimed setup before every run, nullptr for none
+ */
+static BenchResult measure(const string& name, size_t rows, const BenchOptions& options,
+                           const function<void()>& run, const function<void()>& prepare = nullptr) {
+    BenchResult result = { name, rows, {} };
+    for (unsigned int i = 0; i < options.warmup + options.repetitions; ++i) {
+        if (prepare) {
+            prepare();
+        }
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        run();
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        if (i >= options.warmup) {
+            result.samples.push_back(elapsed.count());
+        }
+    }
+
+    vector<double> sorted = result.samples;
+    sort(sorted.begin(), sorted.end());
+    std::cerr << setw(10) << rows << "  " << left << setw(32) << name << right
+              << sorted[sorted.size() / 2] * 1000.0 << " ms" << endl;
+    return result;
+}
+
+/**
+ * Median of sorted samples, the mean of the middle two for an even count
+ */
+static double median(const vector<double>& sorted) {
+    size_t middle = sorted.size() / 2;
+    return sorted.size() % 2 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+}
+
+/**
+ * Percentile of sorted samples by nearest rank; with fewer than 100
+ * samples p99 is the slowest run
+ */
+static double percentile(const vector<double>& sorted, double p) {
+    size_t rank = static_cast<size_t>(ceil(p * sorted.size()));
+    return sorted[max<size_t>(rank, 1) - 1];
+}
+
+/**
+ * Quote a string for JSON
+ */
+static string jsonString(string_view value) {
+    string quoted = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", c);
+            quoted += escape;
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+/**
+ * Write the results as one JSON document, times in seconds
+ *
+ * @param out the stream to write to
+ * @param options the settings the results were measured with
+ * @param threads threads of the pool used by the parallel benchmarks
+ * @param results the benchmarks in the order they ran
+ */
+static void writeJson(ostream& out, const BenchOptions& options, size_t threads,
+                      const vector<BenchResult>& results) {
+    static const char* const TOKENIZERS[] = { "scalar", "sse2", "avx2" };
+
+    out << setprecision(6);
+    out << "{\n";
+    out << "  \"benchmark\": \"BidBench\",\n";
+    out << "  \"format\": " << BENCH_FORMAT << ",\n";
+    out << "  \"unit\": \"seconds\",\n";
+    out << "  \"threads\": " << threads << ",\n";
+    out << "  \"tokenizer\": " << jsonString(TOKENIZERS[csv::getTokenizer()]) << ",\n";
+    out << "  \"warmup\": " << options.warmup << ",\n";
+    out << "  \"repetitions\": " << options.repetitions << ",\n";
+    out << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        vector<double> sorted = results[i].samples;
+        sort(sorted.begin(), sorted.end());
+        double sum = accumulate(sorted.begin(), sorted.end(), 0.0);
+
+        out << (i ? ",\n" : "\n");
+        out << "    { \"name\": " << jsonString(results[i].name)
+            << ", \"rows\": " << results[i].rows
+            << ", \"median\": " << median(sorted)
+            << ", \"p99\": " << percentile(sorted, 0.99)
+            << ", \"min\": " << sorted.front()
+            << ", \"max\": " << sorted.back()
+            << ", \"mean\": " << sum / sorted.size()
+            << ", \"samples\": [";
+        for (size_t k = 0; k < results[i].samples.size(); ++k) {
+            out << (k ? ", " : "") << results[i].samples[k];
+        }
+        out << "] }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+//============================================================================
+// Benchmarks
+//============================================================================
+
+/**
+ * Run every benchmark on one generated file
+ *
+ * @param path the CSV file
+ * @param rows the number of bids in it
+ * @param options warmup, repetitions and threads
+ * @param pool the threads for the parallel sort
+ * @param results where the timings are added
+ */
+static void benchFile(const string& path, size_t rows, const BenchOptions& options, ThreadPool& pool,
+                      vector<BenchResult>& results) {
+    // tokenizing alone, as readBids streams the file
+    results.push_back(measure("parse", rows, options, [&]() {
+        csv::Reader reader(path, ',', 1024 * 1024, options.threads);
+        vector<string_view> row;
+        size_t count = 0;
+        while (reader.next(row)) {
+            ++count;
+        }
+        sink = count;
+    }));
+
+    // a cold load hashes the file, parses and converts every row, then saves
+    // the snapshot
+    unique_ptr<BidBatch> batch;
+    auto freshBatch = [&batch]() { batch.reset(new BidBatch()); };
+    results.push_back(measure("load.csv", rows, options, [&]() {
+        readBids(path, *batch, options.threads);
+    }, [&]() {
+        freshBatch();
+        filesystem::remove(snapshotPath(path));
+    }));
+
+    SnapshotSource source;
+    if (!snapshotSource(path, source)) {
+        throw runtime_error("Failed to examine " + path);
+    }
+    results.push_back(measure("load.snapshot_save", rows, options, [&]() {
+        saveSnapshot(path, source, *batch);
+    }));
+
+    results.push_back(measure("load.snapshot", rows, options, [&]() {
+        if (!readBids(path, *batch, options.threads)) {
+            throw runtime_error("No snapshot of " + path);
+        }
+    }, freshBatch));
+
+    // moving the batch into the global pools; runs after the first find the
+    // strings already interned, as when a file is loaded again
+    vector<Bid> bids;
+    results.push_back(measure("load.append", rows, options, [&]() {
+        appendBids(bids, *batch);
+        sortDictionaries(bids);
+    }, [&]() {
+        bids = vector<Bid>();
+    }));
+    batch.reset();
+    filesystem::remove(snapshotPath(path));
+
+    // every sort starts again from table order
+    vector<uint32_t> view;
+    auto tableView = [&]() { view = tableOrder(bids.size()); };
+    for (int key = eTITLE; key <= eFUND; ++key) {
+        string column = KEY_NAMES[key - 1];
+        SortKey sortKey = static_cast<SortKey>(key);
+        results.push_back(measure("sort.pdq." + column, rows, options, [&]() {
+            argsort(bids, view, sortKey);
+        }, tableView));
+        results.push_back(measure("sort.parallel." + column, rows, options, [&]() {
+            argsort(bids, view, sortKey, false, &pool);
+        }, tableView));
+        results.push_back(measure("sort.radix." + column, rows, options, [&]() {
+            radixArgsort(bids, view, sortKey);
+        }, tableView));
+    }
+    view = vector<uint32_t>();
+
+    BidColumnStore columns;
+    results.push_back(measure("filter.columns", rows, options, [&]() {
+        columns.build(bids);
+    }, [&]() {
+        columns = BidColumnStore();
+    }));
+
+    int firstDay = 0;
+    int lastDay = 0;
+    csv::toDate("1/1/2015", firstDay);
+    csv::toDate("12/31/2015", lastDay);
+    const pair<string, BidFilter> filters[] = {
+        { "amount_between", BidFilter::between(eAMOUNT, 10000, 100000) },
+        { "department_equals", BidFilter::equals(eDEPARTMENT, "ITS") },
+        { "title_prefix", BidFilter::titlePrefix("Dell") },
+        { "title_contains", BidFilter::titleContains("Laptop") },
+        { "date_and_fund", BidFilter::allOf({ BidFilter::between(eCLOSEDATE, firstDay, lastDay),
+                                              BidFilter::equals(eFUND, "General Fund") }) },
+        { "department_or_amount", BidFilter::anyOf({ BidFilter::equals(eDEPARTMENT, "Police"),
+                                                     BidFilter::between(eAMOUNT, 1000000, INT64_MAX) }) }
+    };
+    for (const pair<string, BidFilter>& filter : filters) {
+        results.push_back(measure("filter." + filter.first, rows, options, [&]() {
+            sink = filter.second.select(columns).size();
+        }));
+    }
+}
+
+/**
+ * Every field of a CSV file, header first, as the tokenizer in use reads it
+ *
+ * @param path the CSV file
+ * @param chunkSize bytes tokenized at a time
+ * @param threads threads tokenizing each chunk, 0 for one per hardware thread
+ */
+static vector<vector<string>> readFields(const string& path, size_t chunkSize, unsigned int threads) {
+    csv::Reader reader(path, ',', chunkSize, threads);
+    vector<vector<string>> records;
+    records.push_back(reader.getSchema().names());
+
+    vector<string_view> row;
+    while (reader.next(row)) {
+        records.emplace_back(row.begin(), row.end());
+    }
+    return records;
+}
+
+/**
+ * Read CSV files with every tokenizer this CPU runs and compare the fields
+ * with those of the scalar tokenizer
+ *
+ * @param files the CSV files
+ * @param threads threads tokenizing each chunk, 0 for one per hardware thread
+ * @return true if every tokenizer read the same fields
+ */
+static bool checkTokenizers(const vector<string>& files, unsigned int threads) {
+    static const char* const names[] = { "scalar", "sse2", "avx2" };
+    // chunks the size readBids uses, and small ones that split many records
+    static const size_t chunkSizes[] = { 1024 * 1024, 4096 };
+    bool same = true;
+
+    for (const string& path : files) {
+        for (size_t chunkSize : chunkSizes) {
+            csv::setTokenizer(csv::eSCALAR);
+            vector<vector<string>> expected = readFields(path, chunkSize, threads);
+
+            for (int tokenizer = csv::eSSE2; tokenizer <= csv::bestTokenizer(); ++tokenizer) {
+                csv::setTokenizer(static_cast<csv::Tokenizer>(tokenizer));
+                vector<vector<string>> actual = readFields(path, chunkSize, threads);
+
+                // first record that differs, header included
+                size_t record = 0;
+                while (record < expected.size() && record < actual.size() && expected[record] == actual[record]) {
+                    ++record;
+                }
+                std::cout << path << " (" << chunkSize << " byte chunks): " << names[tokenizer];
+                if (record == expected.size() && record == actual.size()) {
+                    std::cout << " matches scalar, " << expected.size() - 1 << " records" << endl;
+                } else {
+                    std::cout << " differs from scalar at record " << record << endl;
+                    same = false;
+                }
+            }
+        }
+    }
+    csv::setTokenizer(csv::bestTokenizer());
+    return same;
+}
+
+/**
+ * Print how to run the benchmarks
+ */
+static void usage(void) {
+    std::cerr << "Usage: BidBench [--rows N,N,...] [--warmup N] [--repetitions N]" << endl
+              << "                [--threads N] [--dir DIR] [--out FILE]" << endl
+              << "       BidBench --check-tokenizers FILE,FILE,... [--threads N]" << endl
+              << "  --rows         bids per generated file (default 10000,1000000,10000000)" << endl
+              << "  --warmup       untimed runs before each benchmark (default 1)" << endl
+              << "  --repetitions  timed runs of each benchmark (default 5)" << endl
+              << "  --threads      threads for parsing and the parallel sort, 0 = all (default 0)" << endl
+              << "  --dir          where the generated files are kept (default a temp directory)" << endl
+              << "  --out          JSON report file (default standard output)" << endl
+              << "  --check-tokenizers" << endl
+              << "                 read the CSV files with every tokenizer and fail if the fields differ" << endl;
+}
+
+/**
+ * Parse a whole unsigned number, false if the text is anything else
+ */
+static bool parseCount(const string& text, size_t& value) {
+    long long number;
+    if (csv::toInteger(text, number) != std::errc() || number < 0) {
+        return false;
+    }
+    value = static_cast<size_t>(number);
+    return true;
+}
+
+/**
+ * Read the command line into options
+ *
+ * @return false on an unknown or malformed argument
+ */
+static bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        string name = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        string value = argv[++i];
+        size_t number = 0;
+
+        if (name == "--rows") {
+            options.rows.clear();
+            stringstream list(value);
+            string item;
+            while (getline(list, item, ',')) {
+                if (!parseCount(item, number) || number == 0) {
+                    return false;
+                }
+                options.rows.push_back(number);
+            }
+        } else if (name == "--dir") {
+            options.dir = value;
+        } else if (name == "--out") {
+            options.out = value;
+        } else if (name == "--check-tokenizers") {
+            stringstream list(value);
+            string item;
+            while (getline(list, item, ',')) {
+                options.checkFiles.push_back(item);
+            }
+        } else if (!parseCount(value, number)) {
+            return false;
+        } else if (name == "--warmup") {
+            options.warmup = static_cast<unsigned int>(number);
+        } else if (name == "--repetitions" && number > 0) {
+            options.repetitions = static_cast<unsigned int>(number);
+        } else if (name == "--threads") {
+            options.threads = static_cast<unsigned int>(number);
+        } else {
+            return false;
+        }
+    }
+    return !options.rows.empty();
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    options.rows.assign(begin(BENCH_ROWS), end(BENCH_ROWS));
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    try {
+        if (!options.checkFiles.empty()) {
+            return checkTokenizers(options.checkFiles, options.threads) ? 0 : 1;
+        }
+
+        if (options.dir.empty()) {
+            options.dir = (filesystem::temp_directory_path() / "bidbench").string();
+        }
+        filesystem::create_directories(options.dir);
+
+        ThreadPool pool(options.threads);
+        vector<BenchResult> results;
+        for (size_t rows : options.rows) {
+            string path = (filesystem::path(options.dir) / ("bids_" + to_string(rows) + ".csv")).string();
+            if (!filesystem::exists(path)) {
+                std::cerr << "Generating " << path << endl;
+                generateBids(path, rows);
+            }
+            benchFile(path, rows, options, pool, results);
+        }
+
+        if (options.out.empty()) {
+            writeJson(std::cout, options, pool.size(), results);
+        } else {
+            ofstream out(options.out, ios::trunc);
+            writeJson(out, options, pool.size(), results);
+            if (!out) {
+                throw runtime_error("Failed to write " + options.out);
+            }
+        }
+    } catch (exception& e) {
+        std::cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <limits>
+#include "BidFilter.hpp"
+
+using namespace std;
+
+// Rows evaluated at once, small enough that the row bytes of every level
+// of the filter stay in cache
+static const size_t FILTER_BATCH = 4096;
+
+/**
+ * Copy the bid table into one array per column
+ *
+ * @param bids the table
+ */
+void BidColumnStore::build(const vector<Bid>& bids) {
+    append(bids, 0);
+}
+
+/**
+ * Copy the rows appended to the table since the last build or append
+ *
+ * @param bids the table
+ * @param first the first row not stored yet
+ */
+void BidColumnStore::append(const vector<Bid>& bids, size_t first) {
+    size_t count = bids.size();
+
+    bidId.resize(count);
+    title.resize(count);
+    department.resize(count);
+    fund.resize(count);
+    closeDate.resize(count);
+    amount.resize(count);
+    inventoryKey.resize(count);
+    vehicleKey.resize(count);
+    receiptKey.resize(count);
+    ccFee.resize(count);
+    auctionFee.resize(count);
+    expenses.resize(count);
+    netSales.resize(count);
+    for (size_t i = first; i < count; ++i) {
+        const Bid& bid = bids[i];
+        bidId[i] = bid.bidId;
+        title[i] = bid.title;
+        department[i] = bid.department;
+        fund[i] = bid.fund;
+        closeDate[i] = bid.closeDate;
+        amount[i] = bid.amount;
+        inventoryKey[i] = bid.inventoryKey;
+        vehicleKey[i] = bid.vehicleKey;
+        receiptKey[i] = bid.receiptKey;
+        ccFee[i] = bid.ccFee;
+        auctionFee[i] = bid.auctionFee;
+        expenses[i] = bid.expenses;
+        netSales[i] = bid.netSales;
+    }
+}
+
+/**
+ * Drop a row deleted from the table, the rows after it move up one
+ *
+ * @param row the row deleted
+ */
+void BidColumnStore::erase(size_t row) {
+    bidId.erase(bidId.begin() + row);
+    title.erase(title.begin() + row);
+    department.erase(department.begin() + row);
+    fund.erase(fund.begin() + row);
+    closeDate.erase(closeDate.begin() + row);
+    amount.erase(amount.begin() + row);
+    inventoryKey.erase(inventoryKey.begin() + row);
+    vehicleKey.erase(vehicleKey.begin() + row);
+    receiptKey.erase(receiptKey.begin() + row);
+    ccFee.erase(ccFee.begin() + row);
+    auctionFee.erase(auctionFee.begin() + row);
+    expenses.erase(expenses.begin() + row);
+    netSales.erase(netSales.begin() + row);
+}
+
+/**
+ * Copy the department and fund codes again after sortDictionaries
+ * renumbered them
+ *
+ * @param bids the table
+ */
+void BidColumnStore::updateCodes(const vector<Bid>& bids) {
+    for (size_t i = 0; i < department.size(); ++i) {
+        department[i] = bids[i].department;
+        fund[i] = bids[i].fund;
+    }
+}
+
+/**
+ * Number of rows stored
+ */
+size_t BidColumnStore::size(void) const {
+    return bidId.size();
+}
+
+/**
+ * Set out[i] to 1 where low <= values[i] <= high, else 0. Branch-free so
+ * the loop vectorizes.
+ *
+ * @param validLow lowest value that is not a missing-value marker
+ * @param validHigh highest value that is not a missing-value marker
+ */
+template <typename T>
+static void rangeMask(const T* values, size_t count, int64_t low, int64_t high,
+                      int64_t validLow, int64_t validHigh, uint8_t* out) {
+    // clamp the bounds to real values of the column, so Bid::MISSING and
+    // Bid::NO_DATE never match; an empty range matches nothing
+    if (low > high || high < validLow || low > validHigh) {
+        fill(out, out + count, uint8_t(0));
+        return;
+    }
+    T lo = static_cast<T>(max(low, validLow));
+    T hi = static_cast<T>(min(high, validHigh));
+
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = static_cast<uint8_t>((values[i] >= lo) & (values[i] <= hi));
+    }
+}
+
+/**
+ * Constructor for the BidFilter class
+ */
+BidFilter::BidFilter(Kind kind, SortKey column)
+    : _kind(kind), _column(column), _low(0), _high(-1) {
+}
+
+/**
+ * Rows whose numeric column lies in [low, high]. Amounts are in cents,
+ * close dates in days since 1970-01-01, department and fund are codes.
+ */
+BidFilter BidFilter::between(SortKey column, int64_t low, int64_t high) {
+    BidFilter filter(column == eTITLE ? eNONE : eRANGE, column);
+    filter._low = low;
+    filter._high = high;
+    return filter;
+}
+
+/**
+ * Rows whose numeric column equals a value
+ */
+BidFilter BidFilter::equals(SortKey column, int64_t value) {
+    return between(column, value, value);
+}
+
+/**
+ * Rows whose title, department or fund equals a string. Department and
+ * fund compare dictionary codes; a name that never occurs matches nothing.
+ */
+BidFilter BidFilter::equals(SortKey column, string_view value) {
+    if (column == eTITLE) {
+        BidFilter filter(eTEXT_EQUAL, column);
+        filter._text = string(value);
+        return filter;
+    }
+
+    const Dictionary* dictionary = column == eDEPARTMENT ? &bidDepartments
+                                 : column == eFUND ? &bidFunds : nullptr;
+    uint32_t code;
+    if (dictionary == nullptr || !dictionary->find(value, code)) {
+        return BidFilter(eNONE, column);
+    }
+    return between(column, code, code);
+}
+
+/**
+ * Rows whose title starts with a string
+ */
+BidFilter BidFilter::titlePrefix(string_view prefix) {
+    BidFilter filter(ePREFIX);
+    filter._text = string(prefix);
+    return filter;
+}
+
+/**
+ * Rows whose title contains a string
+ */
+BidFilter BidFilter::titleContains(string_view text) {
+    BidFilter filter(eCONTAINS);
+    filter._text = string(text);
+    return filter;
+}
+
+/**
+ * Rows matching every filter (every row if there are none)
+ */
+BidFilter BidFilter::allOf(vector<BidFilter> filters) {
+    BidFilter filter(eALL);
+    filter._children = std::move(filters);
+    return filter;
+}
+
+/**
+ * Rows matching any of the filters (no row if there are none)
+ */
+BidFilter BidFilter::anyOf(vector<BidFilter> filters) {
+    BidFilter filter(eANY);
+    filter._children = std::move(filters);
+    return filter;
+}
+
+/**
+ * Evaluate the filter for rows [begin, begin + count), count at most
+ * FILTER_BATCH, writing 1 for a match and 0 otherwise
+ */
+void BidFilter::evaluate(const BidColumnStore& columns, size_t begin, size_t count, uint8_t* out) const {
+    const int64_t lastId = static_cast<int64_t>(Bid::MISSING) - 1;
+    const int64_t lastCode = numeric_limits<uint32_t>::max();
+
+    switch (_kind) {
+    case eRANGE:
+        switch (_column) {
+        case eBIDID:
+            rangeMask(columns.bidId.data() + begin, count, _low, _high, 0, lastId, out);
+            break;
+        case eDEPARTMENT:
+            rangeMask(columns.department.data() + begin, count, _low, _high, 0, lastCode, out);
+            break;
+        case eCLOSEDATE:
+            rangeMask(columns.closeDate.data() + begin, count, _low, _high,
+                      static_cast<int64_t>(Bid::NO_DATE) + 1, numeric_limits<int32_t>::max(), out);
+            break;
+        case eAMOUNT:
+            rangeMask(columns.amount.data() + begin, count, _low, _high,
+                      numeric_limits<int64_t>::min(), numeric_limits<int64_t>::max(), out);
+            break;
+        case eINVENTORYID:
+            rangeMask(columns.inventoryKey.data() + begin, count, _low, _high, 0, lastId, out);
+            break;
+        case eVEHICLEID:
+            rangeMask(columns.vehicleKey.data() + begin, count, _low, _high, 0, lastId, out);
+            break;
+        case eRECEIPTNUMBER:
+            // receipts past int64 can't be asked for, UINT64_MAX marks a missing one
+            rangeMask(columns.receiptKey.data() + begin, count, _low, _high,
+                      0, numeric_limits<int64_t>::max(), out);
+            break;
+        case eFUND:
+            rangeMask(columns.fund.data() + begin, count, _low, _high, 0, lastCode, out);
+            break;
+        default:
+            fill(out, out + count, uint8_t(0));
+        }
+        break;
+
+    case eTEXT_EQUAL:
+    case ePREFIX:
+    case eCONTAINS:
+        // string tests stay per row
+        for (size_t i = 0; i < count; ++i) {
+            string_view title = text(columns.title[begin + i]);
+            bool match = _kind == eTEXT_EQUAL ? title == _text
+                       : _kind == ePREFIX ? title.substr(0, _text.size()) == _text
+                       : title.find(_text) != string_view::npos;
+            out[i] = static_cast<uint8_t>(match);
+        }
+        break;
+
+    case eALL:
+    case eANY:
+        {
+            uint8_t scratch[FILTER_BATCH];
+            fill(out, out + count, uint8_t(_kind == eALL));
+            for (const BidFilter& child : _children) {
+                child.evaluate(columns, begin, count, scratch);
+                if (_kind == eALL) {
+                    for (size_t i = 0; i < count; ++i) {
+                        out[i] &= scratch[i];
+                    }
+                } else {
+                    for (size_t i = 0; i < count; ++i) {
+                        out[i] |= scratch[i];
+                    }
+                }
+            }
+        }
+        break;
+
+    default:
+        fill(out, out + count, uint8_t(0));
+    }
+}
+
+/**
+ * Rows of the table matching the filter
+ *
+ * @param columns the table as columns
+ * @return matching row numbers, ascending
+ */
+vector<uint32_t> BidFilter::select(const BidColumnStore& columns) const {
+    vector<uint32_t> rows;
+    uint8_t selected[FILTER_BATCH];
+
+    for (size_t begin = 0; begin < columns.size(); begin += FILTER_BATCH) {
+        size_t count = min(FILTER_BATCH, columns.size() - begin);
+        evaluate(columns, begin, count, selected);
+        for (size_t i = 0; i < count; ++i) {
+            if (selected[i]) {
+                rows.push_back(static_cast<uint32_t>(begin + i));
+            }
+        }
+    }
+    return rows;
+}
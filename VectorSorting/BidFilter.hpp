@@ -0,0 +1,73 @@
+#ifndef     _BIDFILTER_HPP_
+# define    _BIDFILTER_HPP_
+
+# include <cstdint>
+# include <string>
+# include <string_view>
+# include <vector>
+# include "Bid.hpp"
+# include "BidSort.hpp"
+
+// The bid table stored one column per array, for filters that scan a
+// column at a time. Rows appended to the table are copied with append(),
+// a row deleted from it is dropped with erase().
+struct BidColumnStore {
+    std::vector<uint32_t> bidId;
+    std::vector<uint32_t> title;
+    std::vector<uint32_t> department;
+    std::vector<uint32_t> fund;
+    std::vector<int32_t> closeDate;
+    std::vector<int64_t> amount;
+    std::vector<uint32_t> inventoryKey;
+    std::vector<uint32_t> vehicleKey;
+    std::vector<uint64_t> receiptKey;
+    std::vector<int64_t> ccFee;
+    std::vector<int64_t> auctionFee;
+    std::vector<int64_t> expenses;
+    std::vector<int64_t> netSales;
+
+    void build(const std::vector<Bid>& bids);
+    void append(const std::vector<Bid>& bids, size_t first);
+    void erase(size_t row);
+    void updateCodes(const std::vector<Bid>& bids);
+    size_t size(void) const;
+};
+
+// Predicate over bid columns: ranges and equality on numeric columns
+// (amount in cents, close date in days; missing values never match),
+// equality on department and fund
+// names, prefix or substring on title, combined with AND / OR. Evaluated
+// over the column store in batches into a byte per row, so numeric
+// comparisons compile to vector code.
+class BidFilter
+{
+  public:
+    static BidFilter between(SortKey column, int64_t low, int64_t high);
+    static BidFilter equals(SortKey column, int64_t value);
+    static BidFilter equals(SortKey column, std::string_view value);   // title, department or fund
+    static BidFilter titlePrefix(std::string_view prefix);
+    static BidFilter titleContains(std::string_view text);
+    static BidFilter allOf(std::vector<BidFilter> filters);
+    static BidFilter anyOf(std::vector<BidFilter> filters);
+
+  public:
+    // Rows of the table matching the filter, ascending
+    std::vector<uint32_t> select(const BidColumnStore& columns) const;
+
+  protected:
+    void evaluate(const BidColumnStore& columns, size_t begin, size_t count, uint8_t* out) const;
+
+  private:
+    enum Kind { eNONE, eRANGE, eTEXT_EQUAL, ePREFIX, eCONTAINS, eALL, eANY };
+
+    BidFilter(Kind kind, SortKey column = eTITLE);
+
+    Kind _kind;
+    SortKey _column;
+    int64_t _low;
+    int64_t _high;
+    std::string _text;
+    std::vector<BidFilter> _children;
+};
+
+#endif /*!_BIDFILTER_HPP_*/
@@ -0,0 +1,200 @@
+#include <algorithm>
+#include "BidIndex.hpp"
+
+using namespace std;
+
+/**
+ * Call visit for each ID of a field listing several ("75160, 75144")
+ */
+template <typename Visit>
+static void forEachId(string_view list, Visit visit) {
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        string_view id = list.substr(0, comma);
+        while (!id.empty() && id.front() == ' ') {
+            id.remove_prefix(1);
+        }
+        while (!id.empty() && id.back() == ' ') {
+            id.remove_suffix(1);
+        }
+        if (!id.empty()) {
+            visit(id);
+        }
+        if (comma == string_view::npos) {
+            break;
+        }
+        list.remove_prefix(comma + 1);
+    }
+}
+
+/**
+ * Drop the entries of a row from a hash index and renumber the rows after
+ * it, which move up one when the row leaves the table
+ */
+template <typename Map>
+static void eraseRow(Map& map, uint32_t row) {
+    for (auto it = map.begin(); it != map.end();) {
+        if (it->second == row) {
+            it = map.erase(it);
+            continue;
+        }
+        if (it->second > row) {
+            --it->second;
+        }
+        ++it;
+    }
+}
+
+/**
+ * Drop the entry of a row from a sorted (key, row) array and renumber the
+ * rows after it. Renumbering keeps equal keys in row order, so the array
+ * stays sorted.
+ */
+template <typename Key>
+static void eraseRow(vector<pair<Key, uint32_t>>& sorted, uint32_t row) {
+    sorted.erase(remove_if(sorted.begin(), sorted.end(),
+                           [row](const pair<Key, uint32_t>& entry) { return entry.second == row; }),
+                 sorted.end());
+    for (pair<Key, uint32_t>& entry : sorted) {
+        if (entry.second > row) {
+            --entry.second;
+        }
+    }
+}
+
+/**
+ * Rows stored under a key of a hash index
+ */
+template <typename Map, typename Key>
+static vector<uint32_t> findEntries(const Map& map, const Key& key) {
+    vector<uint32_t> rows;
+    auto range = map.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+        rows.push_back(it->second);
+    }
+    sort(rows.begin(), rows.end());
+    return rows;
+}
+
+/**
+ * Rows of a sorted (key, row) array with a key in [low, high]
+ */
+template <typename Key>
+static vector<uint32_t> findRange(const vector<pair<Key, uint32_t>>& sorted, Key low, Key high) {
+    vector<uint32_t> rows;
+    auto it = lower_bound(sorted.begin(), sorted.end(), make_pair(low, uint32_t(0)));
+    for (; it != sorted.end() && it->first <= high; ++it) {
+        rows.push_back(it->second);
+    }
+    return rows;
+}
+
+/**
+ * Index the rows appended to a table since it was last indexed, from
+ * row 0 for a new index
+ *
+ * @param bids the table
+ * @param first the first row not indexed yet
+ */
+void BidIndex::append(const vector<Bid>& bids, size_t first) {
+    _bidIds.reserve(bids.size());
+    _receipts.reserve(bids.size());
+    _inventory.reserve(bids.size());
+
+    size_t indexed = _amounts.size();
+    _amounts.reserve(bids.size());
+    _closeDates.reserve(bids.size());
+
+    for (uint32_t row = static_cast<uint32_t>(first); row < bids.size(); ++row) {
+        const Bid& bid = bids[row];
+        _bidIds.emplace(bid.bidId, row);
+        forEachId(text(bid.receiptNumber), [this, row](string_view id) { _receipts.emplace(id, row); });
+        forEachId(text(bid.inventoryID), [this, row](string_view id) { _inventory.emplace(id, row); });
+        _amounts.emplace_back(bid.amount, row);
+        _closeDates.emplace_back(bid.closeDate, row);
+    }
+    // bulk sort the new entries instead of one sorted insert per row, then
+    // merge them with the ones already sorted
+    sort(_amounts.begin() + indexed, _amounts.end());
+    inplace_merge(_amounts.begin(), _amounts.begin() + indexed, _amounts.end());
+    sort(_closeDates.begin() + indexed, _closeDates.end());
+    inplace_merge(_closeDates.begin(), _closeDates.begin() + indexed, _closeDates.end());
+}
+
+/**
+ * Drop a row deleted from the table, the rows after it move up one
+ *
+ * @param row the row deleted
+ */
+void BidIndex::erase(uint32_t row) {
+    eraseRow(_bidIds, row);
+    eraseRow(_receipts, row);
+    eraseRow(_inventory, row);
+    eraseRow(_amounts, row);
+    eraseRow(_closeDates, row);
+}
+
+/**
+ * Tell whether a bid with an Auction ID is indexed
+ */
+bool BidIndex::containsBidId(uint32_t bidId) const {
+    return _bidIds.find(bidId) != _bidIds.end();
+}
+
+/**
+ * Rows of the bids with an Auction ID
+ */
+vector<uint32_t> BidIndex::findBidId(uint32_t bidId) const {
+    return findEntries(_bidIds, bidId);
+}
+
+/**
+ * Rows of the bids listing a receipt number
+ */
+vector<uint32_t> BidIndex::findReceipt(string_view receiptNumber) const {
+    return findEntries(_receipts, receiptNumber);
+}
+
+/**
+ * Rows of the bids listing an inventory ID
+ */
+vector<uint32_t> BidIndex::findInventory(string_view inventoryID) const {
+    return findEntries(_inventory, inventoryID);
+}
+
+/**
+ * Rows of the bids with a winning bid in [low, high] cents, lowest first
+ */
+vector<uint32_t> BidIndex::amountRange(int64_t low, int64_t high) const {
+    return findRange(_amounts, low, high);
+}
+
+/**
+ * Rows of the bids closing between two days (inclusive), earliest first
+ */
+vector<uint32_t> BidIndex::closeDateRange(int32_t first, int32_t last) const {
+    return findRange(_closeDates, first, last);
+}
+
+/**
+ * Append a bid to the table and index it
+ *
+ * @return the row of the new bid
+ */
+uint32_t addBid(vector<Bid>& bids, BidIndex& index, const Bid& bid) {
+    uint32_t row = static_cast<uint32_t>(bids.size());
+    bids.push_back(bid);
+    index.append(bids, row);
+    return row;
+}
+
+/**
+ * Remove a bid from the table and the index, the bids after it move up
+ * one row and keep their order
+ *
+ * @param row the row to remove
+ */
+void deleteBid(vector<Bid>& bids, BidIndex& index, uint32_t row) {
+    index.erase(row);
+    bids.erase(bids.begin() + row);
+}
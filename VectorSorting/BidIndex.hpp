@@ -0,0 +1,47 @@
+#ifndef     _BIDINDEX_HPP_
+# define    _BIDINDEX_HPP_
+
+# include <cstdint>
+# include <string_view>
+# include <unordered_map>
+# include <utility>
+# include <vector>
+# include "Bid.hpp"
+
+// Secondary indexes over a bid table: hash indexes for point lookups on
+// Auction ID, receipt number and inventory ID, and sorted arrays of
+// (key, row) for range lookups on amount and close date. Rows are indexed
+// in bulk with append() as they are appended to the table; go through
+// addBid / deleteBid for single edits.
+class BidIndex
+{
+  public:
+    void append(const std::vector<Bid>& bids, size_t first);
+    void erase(uint32_t row);
+
+  public:
+    bool containsBidId(uint32_t bidId) const;
+    std::vector<uint32_t> findBidId(uint32_t bidId) const;
+    std::vector<uint32_t> findReceipt(std::string_view receiptNumber) const;
+    std::vector<uint32_t> findInventory(std::string_view inventoryID) const;
+
+    // Rows with a key in [low, high], in key order
+    std::vector<uint32_t> amountRange(int64_t low, int64_t high) const;
+    std::vector<uint32_t> closeDateRange(int32_t first, int32_t last) const;
+
+  private:
+    // text keys view bidStrings, which never moves its strings
+    std::unordered_multimap<uint32_t, uint32_t> _bidIds;
+    std::unordered_multimap<std::string_view, uint32_t> _receipts;
+    std::unordered_multimap<std::string_view, uint32_t> _inventory;
+    std::vector<std::pair<int64_t, uint32_t>> _amounts;
+    std::vector<std::pair<int32_t, uint32_t>> _closeDates;
+};
+
+// Table edits that keep an index current, the counterparts of
+// Parser::addRow / deleteRow. deleteBid moves the bids after the deleted
+// one up a row, so views and column stores have to drop the row too.
+uint32_t addBid(std::vector<Bid>& bids, BidIndex& index, const Bid& bid);
+void deleteBid(std::vector<Bid>& bids, BidIndex& index, uint32_t row);
+
+#endif /*!_BIDINDEX_HPP_*/
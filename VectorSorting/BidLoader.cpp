@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+#include <unordered_set>
+#include "BidLoader.hpp"
+
+using namespace std;
+
+/**
+ * Tell whether a file name ends in .csv, in any case
+ */
+static bool isCsvFile(const filesystem::path& path) {
+    string extension = path.extension().string();
+    transform(extension.begin(), extension.end(), extension.begin(),
+              [](unsigned char c) { return static_cast<char>(tolower(c)); });
+    return extension == ".csv";
+}
+
+/**
+ * Expand directories in a list of paths into the CSV files they hold
+ *
+ * @param paths files and directories
+ * @return the files
+ */
+vector<string> csvFiles(const vector<string>& paths) {
+    vector<string> files;
+
+    for (const string& path : paths) {
+        error_code error;
+        if (!filesystem::is_directory(path, error)) {
+            files.push_back(path);
+            continue;
+        }
+
+        vector<string> found;
+        for (const filesystem::directory_entry& entry : filesystem::directory_iterator(path, error)) {
+            if (entry.is_regular_file(error) && isCsvFile(entry.path())) {
+                found.push_back(entry.path().string());
+            }
+        }
+        sort(found.begin(), found.end());
+        files.insert(files.end(), found.begin(), found.end());
+    }
+    return files;
+}
+
+/**
+ * Read every file into a batch of its own
+ *
+ * @param files CSV files
+ * @param pool threads reading the files
+ * @return one batch per file, null for a file that can't be read
+ */
+vector<unique_ptr<BidBatch>> readBatches(const vector<string>& files, ThreadPool& pool) {
+    vector<unique_ptr<BidBatch>> batches(files.size());
+    for (unique_ptr<BidBatch>& batch : batches) {
+        batch.reset(new BidBatch());
+    }
+
+    // a lone file is tokenized on every hardware thread; several files
+    // share the threads out instead of each starting a full set
+    unsigned int threads = files.size() <= 1 ? 0
+        : max(1u, ThreadPool::hardwareThreads() / static_cast<unsigned int>(files.size()));
+
+    pool.run(files.size(), [&](size_t i) {
+        try {
+            readBids(files[i], *batches[i], threads);
+        } catch (exception& e) {
+            cerr << files[i] << ": " << e.what() << endl;
+            batches[i].reset();
+        }
+    });
+    return batches;
+}
+
+/**
+ * Append batches to a table, skipping Auction IDs already loaded
+ *
+ * @param bids the table
+ * @param index the index over the table as it is before the append
+ * @param batches bids read by readBatches, null for a file not read
+ * @return the number of duplicates skipped
+ */
+size_t appendBatches(vector<Bid>& bids, const BidIndex& index, const vector<unique_ptr<BidBatch>>& batches) {
+    // Auction IDs of the batches appended so far
+    unordered_set<uint32_t> earlier;
+    size_t skipped = 0;
+
+    for (const unique_ptr<BidBatch>& batch : batches) {
+        if (!batch) {
+            continue;
+        }
+        appendBids(bids, *batch, [&index, &earlier, &skipped](const Bid& bid) {
+            if (bid.bidId != Bid::MISSING && (index.containsBidId(bid.bidId) || earlier.count(bid.bidId) != 0)) {
+                ++skipped;
+                return false;
+            }
+            return true;
+        });
+        for (const Bid& bid : batch->bids) {
+            earlier.insert(bid.bidId);
+        }
+    }
+    return skipped;
+}
@@ -0,0 +1,29 @@
+#ifndef     _BIDLOADER_HPP_
+# define    _BIDLOADER_HPP_
+
+# include <memory>
+# include <string>
+# include <vector>
+# include "Bid.hpp"
+# include "BidIndex.hpp"
+# include "ThreadPool.hpp"
+
+// CSV files named by a list of paths. A directory stands for the .csv files
+// directly inside it, in name order.
+std::vector<std::string> csvFiles(const std::vector<std::string>& paths);
+
+// Read CSV files at the same time, one batch per file in the order given.
+// A file that can't be read is reported on std::cerr and leaves its batch
+// null.
+std::vector<std::unique_ptr<BidBatch>> readBatches(const std::vector<std::string>& files, ThreadPool& pool);
+
+// Append batches to a table, de-duplicated on Auction ID across files: a
+// bid whose ID is in the index or in an earlier batch is skipped, so the
+// file loaded first wins. Repeats within one file, e.g. an auction paid
+// twice, and bids without an Auction ID are all kept. Null batches are
+// passed over. Returns the number of bids skipped; call sortDictionaries
+// afterwards.
+size_t appendBatches(std::vector<Bid>& bids, const BidIndex& index,
+                     const std::vector<std::unique_ptr<BidBatch>>& batches);
+
+#endif /*!_BIDLOADER_HPP_*/
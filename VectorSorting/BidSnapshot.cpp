@@ -0,0 +1,401 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include "BidSnapshot.hpp"
+
+using namespace std;
+
+static const char SNAPSHOT_MAGIC[8] = { 'B', 'I', 'D', 'S', 'N', 'A', 'P', '\0' };
+
+// Written in native byte order; a snapshot from a machine of the other
+// order reads back as a different value here and is ignored
+static const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+// First bytes of a snapshot file
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t sourceSize;        // bytes of the CSV file
+    int64_t sourceTime;         // modification time of the CSV file
+    uint64_t sourceHash;        // csv::hashBytes() of the CSV file
+    uint64_t rows;
+};
+
+// Size and modification time of a CSV file
+struct SourceStamp {
+    uint64_t size;
+    int64_t time;
+};
+
+/**
+ * Size and modification time of a file
+ *
+ * @return false when the file can't be examined
+ */
+static bool sourceStamp(const string& path, SourceStamp& stamp) {
+    error_code error;
+    uintmax_t size = filesystem::file_size(path, error);
+    if (error) {
+        return false;
+    }
+    filesystem::file_time_type time = filesystem::last_write_time(path, error);
+    if (error) {
+        return false;
+    }
+    stamp.size = size;
+    stamp.time = static_cast<int64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+/**
+ * Hash the contents of a file
+ */
+static uint64_t sourceHash(const string& path) {
+    csv::MappedFile file(path);
+    return csv::hashBytes(file.view());
+}
+
+/**
+ * Size, modification time and content hash of a CSV file
+ *
+ * @param csvPath the CSV file
+ * @param source filled in on success
+ * @return false when the file can't be examined
+ */
+bool snapshotSource(const string& csvPath, SnapshotSource& source) {
+    SourceStamp stamp;
+    if (!sourceStamp(csvPath, stamp)) {
+        return false;
+    }
+    source.size = stamp.size;
+    source.time = stamp.time;
+    source.hash = sourceHash(csvPath);
+    return true;
+}
+
+/**
+ * Bytes needed to pad size up to a multiple of 8, so every section of a
+ * snapshot starts aligned
+ */
+static size_t padding(size_t size) {
+    return (8 - size % 8) % 8;
+}
+
+/**
+ * Write one column of the bids as an array
+ */
+template <typename T>
+static void writeColumn(ofstream& out, const vector<Bid>& bids, T Bid::* member) {
+    vector<T> values(bids.size());
+    for (size_t i = 0; i < bids.size(); ++i) {
+        values[i] = bids[i].*member;
+    }
+    static const char zeros[8] = {};
+    out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    out.write(zeros, padding(values.size() * sizeof(T)));
+}
+
+/**
+ * Write a string table: the count, count + 1 offsets, then the bytes
+ *
+ * @param count number of strings
+ * @param value function returning string i
+ */
+template <typename Values>
+static void writeStrings(ofstream& out, uint32_t count, Values value) {
+    vector<uint64_t> offsets(count + 1);
+    for (uint32_t i = 0; i < count; ++i) {
+        offsets[i + 1] = offsets[i] + value(i).size();
+    }
+
+    static const char zeros[8] = {};
+    uint64_t size = count;
+    out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    for (uint32_t i = 0; i < count; ++i) {
+        string_view text = value(i);
+        out.write(text.data(), text.size());
+    }
+    out.write(zeros, padding(offsets[count]));
+}
+
+/**
+ * Path of the snapshot belonging to a CSV file
+ *
+ * @param csvPath the CSV file
+ */
+string snapshotPath(const string& csvPath) {
+    return csvPath + ".snapshot";
+}
+
+/**
+ * Write the snapshot of a CSV file
+ *
+ * @param csvPath the CSV file the bids were parsed from
+ * @param source the file as it was before it was parsed
+ * @param batch every bid of the file
+ */
+void saveSnapshot(const string& csvPath, const SnapshotSource& source, const BidBatch& batch) {
+    const vector<Bid>& bids = batch.bids;
+    SnapshotHeader header;
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.sourceSize = source.size;
+    header.sourceTime = source.time;
+    header.sourceHash = source.hash;
+    header.rows = bids.size();
+
+    string path = snapshotPath(csvPath);
+    string partial = path + ".tmp";
+    {
+        ofstream out(partial, ios::binary | ios::trunc);
+        if (!out) {
+            throw runtime_error("Failed to create " + partial);
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        // same columns, same order as loadSnapshot reads them
+        writeColumn(out, bids, &Bid::bidId);
+        writeColumn(out, bids, &Bid::title);
+        writeColumn(out, bids, &Bid::department);
+        writeColumn(out, bids, &Bid::fund);
+        writeColumn(out, bids, &Bid::inventoryID);
+        writeColumn(out, bids, &Bid::vehicleID);
+        writeColumn(out, bids, &Bid::receiptNumber);
+        writeColumn(out, bids, &Bid::closeDate);
+        writeColumn(out, bids, &Bid::amount);
+        writeColumn(out, bids, &Bid::ccFee);
+        writeColumn(out, bids, &Bid::auctionFee);
+        writeColumn(out, bids, &Bid::expenses);
+        writeColumn(out, bids, &Bid::netSales);
+        writeColumn(out, bids, &Bid::inventoryKey);
+        writeColumn(out, bids, &Bid::vehicleKey);
+        writeColumn(out, bids, &Bid::receiptKey);
+
+        writeStrings(out, batch.strings.size(), [&batch](uint32_t i) { return batch.strings.view(i); });
+        writeStrings(out, batch.departments.size(), [&batch](uint32_t i) { return batch.departments.decode(i); });
+        writeStrings(out, batch.funds.size(), [&batch](uint32_t i) { return batch.funds.decode(i); });
+
+        out.close();
+        if (!out) {
+            remove(partial.c_str());
+            throw runtime_error("Failed to write " + partial);
+        }
+    }
+
+    error_code error;
+    filesystem::rename(partial, path, error);
+    if (error) {
+        remove(partial.c_str());
+        throw runtime_error("Failed to replace " + path);
+    }
+}
+
+// Bounds-checked cursor over a mapped snapshot
+class SnapshotReader {
+  public:
+    SnapshotReader(string_view bytes)
+        : _bytes(bytes), _at(0), _ok(true) {
+    }
+
+    // next size bytes, then skip the padding after them; nullptr once the
+    // file turns out too short
+    const char* take(size_t size) {
+        if (!_ok || size > _bytes.size() - _at || padding(size) > _bytes.size() - _at - size) {
+            _ok = false;
+            return nullptr;
+        }
+        const char* data = _bytes.data() + _at;
+        _at += size + padding(size);
+        return data;
+    }
+
+    bool ok(void) const {
+        return _ok;
+    }
+
+  private:
+    string_view _bytes;
+    size_t _at;
+    bool _ok;
+};
+
+/**
+ * Locate the array of one column
+ *
+ * @return the array, nullptr when the file is too short
+ */
+template <typename T>
+static const char* columnData(SnapshotReader& in, size_t rows) {
+    return rows > SIZE_MAX / sizeof(T) ? nullptr : in.take(rows * sizeof(T));
+}
+
+/**
+ * Value of one row of a column array
+ */
+template <typename T>
+static T field(const char* column, size_t row) {
+    T value;
+    memcpy(&value, column + row * sizeof(T), sizeof(T));
+    return value;
+}
+
+/**
+ * Read a string table as views into the mapped file
+ *
+ * @return false when the table is damaged
+ */
+static bool readStrings(SnapshotReader& in, vector<string_view>& values) {
+    const char* data = in.take(sizeof(uint64_t));
+    if (data == nullptr) {
+        return false;
+    }
+    uint64_t count;
+    memcpy(&count, data, sizeof(count));
+    if (count == 0 || count >= UINT32_MAX) {
+        return false;
+    }
+
+    const char* offsetData = in.take((count + 1) * sizeof(uint64_t));
+    if (offsetData == nullptr) {
+        return false;
+    }
+    vector<uint64_t> offsets(count + 1);
+    memcpy(offsets.data(), offsetData, offsets.size() * sizeof(uint64_t));
+    for (uint64_t i = 0; i < count; ++i) {
+        if (offsets[i] > offsets[i + 1]) {
+            return false;
+        }
+    }
+    const char* text = offsets[0] == 0 && offsets[count] < SIZE_MAX ? in.take(offsets[count]) : nullptr;
+    if (text == nullptr) {
+        return false;
+    }
+
+    values.resize(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        values[i] = string_view(text + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+    return true;
+}
+
+/**
+ * Append the bids of a CSV file from its snapshot
+ *
+ * @param csvPath the CSV file
+ * @param batch batch to append the bids to
+ * @return false when there is no up-to-date snapshot
+ */
+bool loadSnapshot(const string& csvPath, BidBatch& batch) {
+    vector<Bid>& bids = batch.bids;
+    string path = snapshotPath(csvPath);
+    SourceStamp stamp;
+    error_code error;
+    if (!sourceStamp(csvPath, stamp) || !filesystem::exists(path, error)) {
+        return false;
+    }
+
+    csv::MappedFile file(path);
+    SnapshotReader in(file.view());
+    const char* headerData = in.take(sizeof(SnapshotHeader));
+    if (headerData == nullptr) {
+        return false;
+    }
+    SnapshotHeader header;
+    memcpy(&header, headerData, sizeof(header));
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version != SNAPSHOT_VERSION
+        || header.byteOrder != SNAPSHOT_BYTE_ORDER) {
+        return false;
+    }
+    // the cheap checks first, the hash reads the whole CSV file
+    if (header.sourceSize != stamp.size || header.sourceTime != stamp.time
+        || header.rows > file.view().size() || header.sourceHash != sourceHash(csvPath)) {
+        return false;
+    }
+
+    size_t rows = static_cast<size_t>(header.rows);
+    const char* bidId = columnData<uint32_t>(in, rows);
+    const char* title = columnData<uint32_t>(in, rows);
+    const char* department = columnData<uint32_t>(in, rows);
+    const char* fund = columnData<uint32_t>(in, rows);
+    const char* inventoryID = columnData<uint32_t>(in, rows);
+    const char* vehicleID = columnData<uint32_t>(in, rows);
+    const char* receiptNumber = columnData<uint32_t>(in, rows);
+    const char* closeDate = columnData<int32_t>(in, rows);
+    const char* amount = columnData<int64_t>(in, rows);
+    const char* ccFee = columnData<int64_t>(in, rows);
+    const char* auctionFee = columnData<int64_t>(in, rows);
+    const char* expenses = columnData<int64_t>(in, rows);
+    const char* netSales = columnData<int64_t>(in, rows);
+    const char* inventoryKey = columnData<uint32_t>(in, rows);
+    const char* vehicleKey = columnData<uint32_t>(in, rows);
+    const char* receiptKey = columnData<uint64_t>(in, rows);
+
+    // all of the columns are rows long, so one check covers them
+    bool ok = in.ok();
+    vector<string_view> strings, departmentValues, fundValues;
+    ok = ok && readStrings(in, strings) && readStrings(in, departmentValues) && readStrings(in, fundValues);
+    if (!ok) {
+        return false;
+    }
+
+    // rows are built in one pass that reads every column array in step,
+    // checking every handle and code before anything is interned so a
+    // damaged snapshot leaves the batch as it was
+    size_t first = bids.size();
+    bids.resize(first + rows);
+    for (size_t i = 0; i < rows; ++i) {
+        Bid& bid = bids[first + i];
+        bid.bidId = field<uint32_t>(bidId, i);
+        bid.title = field<uint32_t>(title, i);
+        bid.department = field<uint32_t>(department, i);
+        bid.fund = field<uint32_t>(fund, i);
+        bid.inventoryID = field<uint32_t>(inventoryID, i);
+        bid.vehicleID = field<uint32_t>(vehicleID, i);
+        bid.receiptNumber = field<uint32_t>(receiptNumber, i);
+        bid.closeDate = field<int32_t>(closeDate, i);
+        bid.amount = field<int64_t>(amount, i);
+        bid.ccFee = field<int64_t>(ccFee, i);
+        bid.auctionFee = field<int64_t>(auctionFee, i);
+        bid.expenses = field<int64_t>(expenses, i);
+        bid.netSales = field<int64_t>(netSales, i);
+        bid.inventoryKey = field<uint32_t>(inventoryKey, i);
+        bid.vehicleKey = field<uint32_t>(vehicleKey, i);
+        bid.receiptKey = field<uint64_t>(receiptKey, i);
+        ok &= (bid.title < strings.size()) & (bid.inventoryID < strings.size())
+            & (bid.vehicleID < strings.size()) & (bid.receiptNumber < strings.size())
+            & (bid.department < departmentValues.size()) & (bid.fund < fundValues.size());
+    }
+    if (!ok) {
+        bids.resize(first);
+        return false;
+    }
+
+    vector<uint32_t> handles(strings.size()), departments(departmentValues.size()), funds(fundValues.size());
+    for (size_t i = 0; i < strings.size(); ++i) {
+        handles[i] = batch.strings.intern(strings[i]);
+    }
+    for (size_t i = 0; i < departmentValues.size(); ++i) {
+        departments[i] = batch.departments.encode(departmentValues[i]);
+    }
+    for (size_t i = 0; i < fundValues.size(); ++i) {
+        funds[i] = batch.funds.encode(fundValues[i]);
+    }
+
+    // handles and codes of the snapshot become those of the batch pools
+    for (size_t i = first; i < bids.size(); ++i) {
+        Bid& bid = bids[i];
+        bid.title = handles[bid.title];
+        bid.inventoryID = handles[bid.inventoryID];
+        bid.vehicleID = handles[bid.vehicleID];
+        bid.receiptNumber = handles[bid.receiptNumber];
+        bid.department = departments[bid.department];
+        bid.fund = funds[bid.fund];
+    }
+    return true;
+}
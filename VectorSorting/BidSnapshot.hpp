@@ -0,0 +1,42 @@
+#ifndef     _BIDSNAPSHOT_HPP_
+# define    _BIDSNAPSHOT_HPP_
+
+# include <cstdint>
+# include <string>
+# include <vector>
+# include "Bid.hpp"
+
+// Format of snapshot files; bump it whenever a column of Bid changes, older
+// snapshots are then ignored and rewritten
+static const uint32_t SNAPSHOT_VERSION = 1;
+
+// Binary snapshot of the bids of one CSV file, kept next to the file. Every
+// column of Bid is stored as one fixed-width array, followed by the string
+// heap and the values of both dictionaries of the batch. The header
+// records the size, modification time and content hash of the CSV file; a
+// snapshot whose source no longer matches is stale.
+std::string snapshotPath(const std::string& csvPath);
+
+// Map the snapshot of a CSV file and append its bids to a batch. Returns
+// false, leaving the batch untouched, when there is no valid snapshot for
+// the file as it is now.
+bool loadSnapshot(const std::string& csvPath, BidBatch& batch);
+
+// Size, modification time and content hash of a CSV file. Taken before the
+// file is parsed, so a file changed during the parse gets a snapshot that
+// no longer matches it instead of one vouching for the old rows.
+struct SnapshotSource {
+    uint64_t size;
+    int64_t time;
+    uint64_t hash;
+};
+
+// Examine a CSV file, false when it can't be
+bool snapshotSource(const std::string& csvPath, SnapshotSource& source);
+
+// Write the snapshot of a CSV file just parsed into a batch, stamped with
+// the source taken before parsing. The file is written aside and renamed
+// into place, so readers never see half of it.
+void saveSnapshot(const std::string& csvPath, const SnapshotSource& source, const BidBatch& batch);
+
+#endif /*!_BIDSNAPSHOT_HPP_*/
@@ -0,0 +1,478 @@
+#include <algorithm>
+#include <numeric>
+#include <string_view>
+#include "BidSort.hpp"
+#include "ParallelSort.hpp"
+#include "PdqSort.hpp"
+
+using namespace std;
+
+// Numeric sort key of a row stored next to the row number, so a numeric sort
+// walks one dense array instead of reaching into the bid table
+struct KeyRow {
+    uint64_t key;
+    uint32_t row;
+};
+
+/**
+ * Map a numeric column to an unsigned key with the same ordering,
+ * titles map to 0
+ *
+ * @param bid the bid to read
+ * @param key the column to read
+ */
+uint64_t orderedKey(const Bid& bid, SortKey key) {
+    switch (key) {
+    case eBIDID:
+        return bid.bidId;
+    case eDEPARTMENT:
+        return bid.department;
+    case eCLOSEDATE:
+        // flip the sign bit so negative days order below positive ones
+        return static_cast<uint32_t>(bid.closeDate) ^ 0x80000000u;
+    case eAMOUNT:
+        return static_cast<uint64_t>(bid.amount) ^ 0x8000000000000000ull;
+    case eINVENTORYID:
+        return bid.inventoryKey;
+    case eVEHICLEID:
+        return bid.vehicleKey;
+    case eRECEIPTNUMBER:
+        return bid.receiptKey;
+    case eFUND:
+        return bid.fund;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Sort key of a numeric column in the given direction: orderedKey,
+ * complemented for descending order, with a missing value (Bid::MISSING,
+ * Bid::NO_DATE, a receipt key of all ones) mapped past every real value so
+ * it sorts last either way
+ *
+ * @param bid the bid to read
+ * @param key the column to read
+ * @param descending true for largest first
+ */
+uint64_t directedKey(const Bid& bid, SortKey key, bool descending) {
+    bool missing = false;
+    switch (key) {
+    case eBIDID:
+        missing = bid.bidId == Bid::MISSING;
+        break;
+    case eCLOSEDATE:
+        missing = bid.closeDate == Bid::NO_DATE;
+        break;
+    case eINVENTORYID:
+        missing = bid.inventoryKey == Bid::MISSING;
+        break;
+    case eVEHICLEID:
+        missing = bid.vehicleKey == Bid::MISSING;
+        break;
+    case eRECEIPTNUMBER:
+        missing = bid.receiptKey == UINT64_MAX;
+        break;
+    default:
+        break;
+    }
+    if (missing) {
+        return UINT64_MAX;
+    }
+    // real values stay below UINT64_MAX in both directions
+    uint64_t value = orderedKey(bid, key);
+    return descending ? UINT64_MAX - 1 - value : min<uint64_t>(value, UINT64_MAX - 1);
+}
+
+/**
+ * Row numbers of a table in table order
+ *
+ * @param size number of rows
+ */
+vector<uint32_t> tableOrder(size_t size) {
+    vector<uint32_t> rows(size);
+    iota(rows.begin(), rows.end(), 0);
+    return rows;
+}
+
+/**
+ * Sort row numbers by a column, the bids themselves never move.
+ * Equal keys keep ascending row order, so a view only depends on the
+ * table and the column, not on how it was sorted before.
+ *
+ * @param bids the table the rows refer to
+ * @param rows row numbers to reorder
+ * @param key column to order by
+ * @param descending true for largest first
+ * @param pool threads for large views, or nullptr to sort on this thread
+ */
+void argsort(const vector<Bid>& bids, vector<uint32_t>& rows, SortKey key, bool descending,
+             ThreadPool* pool) {
+    if (key == eTITLE) {
+        auto byTitle = [&bids, descending](uint32_t a, uint32_t b) {
+            int order = text(bids[a].title).compare(text(bids[b].title));
+            if (order != 0) {
+                return descending ? order > 0 : order < 0;
+            }
+            return a < b;
+        };
+        if (pool) {
+            pdq::parallelSort(rows, byTitle, *pool);
+        } else {
+            pdq::pdqsort(rows.begin(), rows.end(), byTitle);
+        }
+        return;
+    }
+
+    vector<KeyRow> keys(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        keys[i].key = directedKey(bids[rows[i]], key, descending);
+        keys[i].row = rows[i];
+    }
+    auto byKey = [](const KeyRow& a, const KeyRow& b) {
+        return a.key != b.key ? a.key < b.key : a.row < b.row;
+    };
+    if (pool) {
+        pdq::parallelSort<true>(keys, byKey, *pool);
+    } else {
+        pdq::pdqsortBranchless(keys.begin(), keys.end(), byKey);
+    }
+    for (size_t i = 0; i < rows.size(); ++i) {
+        rows[i] = keys[i].row;
+    }
+}
+
+/**
+ * Merge rows appended to the table into a view
+ *
+ * @param bids the table, rows from first on are not in the view yet
+ * @param rows the view
+ * @param first the first appended row
+ * @param order how the view is ordered
+ */
+void mergeRows(const vector<Bid>& bids, vector<uint32_t>& rows, size_t first, const ViewOrder& order) {
+    // sort the new rows alone, then merge the two sorted runs
+    vector<uint32_t> added(bids.size() - first);
+    iota(added.begin(), added.end(), static_cast<uint32_t>(first));
+    if (order.sorted) {
+        argsort(bids, added, order.key, order.descending);
+    }
+    size_t middle = rows.size();
+    rows.insert(rows.end(), added.begin(), added.end());
+    if (!order.sorted) {
+        return;
+    }
+
+    if (order.key == eTITLE) {
+        inplace_merge(rows.begin(), rows.begin() + middle, rows.end(),
+                      [&bids, &order](uint32_t a, uint32_t b) {
+                          int compare = text(bids[a].title).compare(text(bids[b].title));
+                          if (compare != 0) {
+                              return order.descending ? compare > 0 : compare < 0;
+                          }
+                          return a < b;
+                      });
+    } else {
+        inplace_merge(rows.begin(), rows.begin() + middle, rows.end(),
+                      [&bids, &order](uint32_t a, uint32_t b) {
+                          uint64_t keyA = directedKey(bids[a], order.key, order.descending);
+                          uint64_t keyB = directedKey(bids[b], order.key, order.descending);
+                          if (keyA != keyB) {
+                              return keyA < keyB;
+                          }
+                          return a < b;
+                      });
+    }
+}
+
+/**
+ * Drop a row deleted from the table from a view. The rows after it move up
+ * one, which keeps ties in ascending row order.
+ *
+ * @param rows the view
+ * @param row the row deleted
+ */
+void removeRow(vector<uint32_t>& rows, uint32_t row) {
+    rows.erase(remove(rows.begin(), rows.end(), row), rows.end());
+    for (uint32_t& other : rows) {
+        if (other > row) {
+            --other;
+        }
+    }
+}
+
+// Below this many rows a title range is finished with a comparison sort
+static const size_t RADIX_MIN_RANGE = 64;
+
+/**
+ * Row numbers of a view in ascending order, in O(table size). Radix sorts
+ * are stable, so starting from here gives ties the same ascending row order
+ * argsort uses.
+ *
+ * @param tableSize number of bids in the table
+ * @param rows the view
+ */
+static vector<uint32_t> ascendingRows(size_t tableSize, const vector<uint32_t>& rows) {
+    vector<bool> inView(tableSize, false);
+    vector<uint32_t> ascending;
+
+    for (uint32_t row : rows) {
+        inView[row] = true;
+    }
+    ascending.reserve(rows.size());
+    for (size_t row = 0; row < tableSize; ++row) {
+        if (inView[row]) {
+            ascending.push_back(static_cast<uint32_t>(row));
+        }
+    }
+    return ascending;
+}
+
+/**
+ * Stable LSD radix sort of (key, row) pairs on 8-bit digits. One pass
+ * counts all eight digits, and digits every key shares are skipped, so
+ * small keys such as dictionary codes take one or two passes.
+ *
+ * @param keys first pair to sort
+ * @param count number of pairs
+ * @param buffer scratch space for count pairs
+ */
+static void radixSortKeys(KeyRow* keys, size_t count, KeyRow* buffer) {
+    static const int DIGITS = 8;
+    vector<size_t> counts(DIGITS * 256, 0);
+
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t key = keys[i].key;
+        for (int digit = 0; digit < DIGITS; ++digit) {
+            counts[digit * 256 + ((key >> (8 * digit)) & 0xFF)]++;
+        }
+    }
+
+    KeyRow* from = keys;
+    KeyRow* to = buffer;
+    for (int digit = 0; digit < DIGITS; ++digit) {
+        size_t* histogram = &counts[digit * 256];
+        int shift = 8 * digit;
+        if (count == 0 || histogram[(from[0].key >> shift) & 0xFF] == count) {
+            continue;
+        }
+        size_t offset = 0;
+        for (int value = 0; value < 256; ++value) {
+            size_t size = histogram[value];
+            histogram[value] = offset;
+            offset += size;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            to[histogram[(from[i].key >> shift) & 0xFF]++] = from[i];
+        }
+        swap(from, to);
+    }
+    if (from != keys) {
+        copy(from, from + count, keys);
+    }
+}
+
+/**
+ * Pack the 8 bytes of a string starting at depth into an integer that
+ * orders like the bytes do, padding with zeros past the end
+ *
+ * @param value the string
+ * @param depth offset of the first byte
+ */
+static uint64_t prefixAt(string_view value, size_t depth) {
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        prefix <<= 8;
+        if (depth + i < value.size()) {
+            prefix |= static_cast<unsigned char>(value[depth + i]);
+        }
+    }
+    return prefix;
+}
+
+/**
+ * Comparison sort of titles that share their first depth bytes
+ *
+ * @param bids the table the rows refer to
+ * @param items rows to sort
+ * @param count number of rows
+ * @param depth number of leading bytes all titles share
+ * @param descending true for largest first
+ */
+static void compareSortTitles(const vector<Bid>& bids, KeyRow* items, size_t count, size_t depth,
+                              bool descending) {
+    pdq::pdqsort(items, items + count, [&bids, depth, descending](const KeyRow& a, const KeyRow& b) {
+        int order = text(bids[a.row].title).substr(depth).compare(text(bids[b.row].title).substr(depth));
+        if (order != 0) {
+            return descending ? order > 0 : order < 0;
+        }
+        return a.row < b.row;
+    });
+}
+
+/**
+ * MSD radix sort of titles: sort on the 8-byte prefix at depth, then
+ * resolve each run of equal prefixes on the next 8 bytes. Runs that are
+ * small, or hold a title ending inside the prefix, fall back to comparing
+ * the rest of the strings.
+ *
+ * @param bids the table the rows refer to
+ * @param items rows to sort, keys are overwritten
+ * @param count number of rows
+ * @param buffer scratch space for count pairs
+ * @param depth number of leading bytes all titles are known to share
+ * @param descending true for largest first
+ */
+static void radixSortTitles(const vector<Bid>& bids, KeyRow* items, size_t count, KeyRow* buffer,
+                            size_t depth, bool descending) {
+    if (count < RADIX_MIN_RANGE) {
+        compareSortTitles(bids, items, count, depth, descending);
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t prefix = prefixAt(text(bids[items[i].row].title), depth);
+        items[i].key = descending ? ~prefix : prefix;
+    }
+    radixSortKeys(items, count, buffer);
+
+    size_t begin = 0;
+    while (begin < count) {
+        size_t end = begin + 1;
+        bool longer = text(bids[items[begin].row].title).size() > depth + 8;
+        while (end < count && items[end].key == items[begin].key) {
+            longer = longer && text(bids[items[end].row].title).size() > depth + 8;
+            ++end;
+        }
+        if (end - begin > 1) {
+            if (longer) {
+                radixSortTitles(bids, items + begin, end - begin, buffer, depth + 8, descending);
+            } else {
+                compareSortTitles(bids, items + begin, end - begin, depth, descending);
+            }
+        }
+        begin = end;
+    }
+}
+
+/**
+ * Sort row numbers by a column with radix sorts instead of comparisons.
+ * The result is the same permutation argsort produces. Like every view,
+ * rows must not repeat a row number.
+ *
+ * @param bids the table the rows refer to
+ * @param rows row numbers to reorder
+ * @param key column to order by
+ * @param descending true for largest first
+ */
+void radixArgsort(const vector<Bid>& bids, vector<uint32_t>& rows, SortKey key, bool descending) {
+    vector<uint32_t> ascending = ascendingRows(bids.size(), rows);
+    vector<KeyRow> keys(ascending.size());
+    vector<KeyRow> buffer(ascending.size());
+
+    for (size_t i = 0; i < ascending.size(); ++i) {
+        keys[i].row = ascending[i];
+        if (key != eTITLE) {
+            keys[i].key = directedKey(bids[ascending[i]], key, descending);
+        }
+    }
+    if (key == eTITLE) {
+        radixSortTitles(bids, keys.data(), keys.size(), buffer.data(), 0, descending);
+    } else {
+        radixSortKeys(keys.data(), keys.size(), buffer.data());
+    }
+    for (size_t i = 0; i < rows.size(); ++i) {
+        rows[i] = keys[i].row;
+    }
+}
+
+/**
+ * Pick positions first .. end - 1 of the order less gives to the rows
+ *
+ * @param rows the view
+ * @param first first position wanted
+ * @param end one past the last position wanted, at most rows.size()
+ * @param less strict order of the items
+ * @param make builds the item compared for a row
+ * @return the picked items in order
+ */
+template <typename T, typename Compare, typename Make>
+static vector<T> selectItems(const vector<uint32_t>& rows, size_t first, size_t end, Compare less, Make make) {
+    vector<T> items;
+
+    if (first == 0) {
+        // max-heap of the best end items seen so far, the worst on top
+        items.reserve(end);
+        for (uint32_t row : rows) {
+            T item = make(row);
+            if (items.size() < end) {
+                items.push_back(item);
+                push_heap(items.begin(), items.end(), less);
+            } else if (less(item, items.front())) {
+                pop_heap(items.begin(), items.end(), less);
+                items.back() = item;
+                push_heap(items.begin(), items.end(), less);
+            }
+        }
+        sort_heap(items.begin(), items.end(), less);
+        return items;
+    }
+
+    items.reserve(rows.size());
+    for (uint32_t row : rows) {
+        items.push_back(make(row));
+    }
+    nth_element(items.begin(), items.begin() + first, items.end(), less);
+    partial_sort(items.begin() + first, items.begin() + end, items.end(), less);
+    items.erase(items.begin() + end, items.end());
+    items.erase(items.begin(), items.begin() + first);
+    return items;
+}
+
+/**
+ * Rows at positions first .. first + count - 1 of the order argsort
+ * would give the view, the view itself is not reordered
+ *
+ * @param bids the table the rows refer to
+ * @param rows the view
+ * @param key column to order by
+ * @param descending true for largest first
+ * @param first first position wanted
+ * @param count number of positions wanted
+ */
+vector<uint32_t> selectRange(const vector<Bid>& bids, const vector<uint32_t>& rows, SortKey key,
+                             bool descending, size_t first, size_t count) {
+    vector<uint32_t> selected;
+    size_t end = rows.size();
+
+    if (first < end && count < end - first) {
+        end = first + count;
+    }
+    if (first >= end) {
+        return selected;
+    }
+
+    if (key == eTITLE) {
+        auto byTitle = [&bids, descending](uint32_t a, uint32_t b) {
+            int order = text(bids[a].title).compare(text(bids[b].title));
+            if (order != 0) {
+                return descending ? order > 0 : order < 0;
+            }
+            return a < b;
+        };
+        return selectItems<uint32_t>(rows, first, end, byTitle, [](uint32_t row) { return row; });
+    }
+
+    auto byKey = [](const KeyRow& a, const KeyRow& b) {
+        return a.key != b.key ? a.key < b.key : a.row < b.row;
+    };
+    vector<KeyRow> keys = selectItems<KeyRow>(rows, first, end, byKey, [&bids, key, descending](uint32_t row) {
+        KeyRow item = { directedKey(bids[row], key, descending), row };
+        return item;
+    });
+    selected.reserve(keys.size());
+    for (const KeyRow& item : keys) {
+        selected.push_back(item.row);
+    }
+    return selected;
+}
@@ -0,0 +1,61 @@
+#ifndef     _BIDSORT_HPP_
+# define    _BIDSORT_HPP_
+
+# include <cstdint>
+# include <vector>
+# include "Bid.hpp"
+# include "ThreadPool.hpp"
+
+// Columns a bid table can be ordered by, numbered like the filter menu
+enum SortKey
+{
+    eTITLE = 1,
+    eBIDID,
+    eDEPARTMENT,
+    eCLOSEDATE,
+    eAMOUNT,
+    eINVENTORYID,
+    eVEHICLEID,
+    eRECEIPTNUMBER,
+    eFUND
+};
+
+// A view over a bid table is a permutation of its row numbers: sorting only
+// reorders the permutation, so any number of views can share one table.
+// Given a pool, large views are sorted in parallel.
+std::vector<uint32_t> tableOrder(size_t size);
+uint64_t orderedKey(const Bid& bid, SortKey key);   // numeric columns only
+// Key numeric sorts compare: orderedKey in the given direction, with missing
+// values (no Auction ID, close date, ...) last in both directions
+uint64_t directedKey(const Bid& bid, SortKey key, bool descending);
+void argsort(const std::vector<Bid>& bids, std::vector<uint32_t>& rows, SortKey key,
+             bool descending = false, ThreadPool* pool = nullptr);
+
+// How a view is ordered: by argsort on a column, or in table order
+struct ViewOrder {
+    bool sorted;
+    SortKey key;
+    bool descending;
+};
+
+// Add the rows appended to the table from first on to a view, merged into
+// its order in O(n + m log m) instead of sorting the whole view again. Equal
+// keys put the new rows last, as argsort would.
+void mergeRows(const std::vector<Bid>& bids, std::vector<uint32_t>& rows, size_t first, const ViewOrder& order);
+
+// Drop a row deleted from the table from a view, renumbering the rows after
+// it. The view keeps its order.
+void removeRow(std::vector<uint32_t>& rows, uint32_t row);
+
+// Same ordering as argsort without comparison sorting: numeric columns take
+// an LSD radix sort, titles an MSD radix sort over 8-byte prefixes.
+void radixArgsort(const std::vector<Bid>& bids, std::vector<uint32_t>& rows, SortKey key,
+                  bool descending = false);
+
+// Positions first .. first + count - 1 of the order argsort would give,
+// without sorting the view: top-K queries keep a bounded heap, O(n log k),
+// ranges further down select with nth_element first.
+std::vector<uint32_t> selectRange(const std::vector<Bid>& bids, const std::vector<uint32_t>& rows,
+                                  SortKey key, bool descending, size_t first, size_t count);
+
+#endif /*!_BIDSORT_HPP_*/
@@ -2,9 +2,39 @@
 #include <sstream>
 #include <iomanip>
 #include "CSVparser.hpp"
+#include "ThreadPool.hpp"
 #include <iostream>
 #include <ctime>
 #include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# define NOMINMAX
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+# define CSV_X86_SIMD
+# include <immintrin.h>
+# if defined(_MSC_VER)
+#  include <intrin.h>
+#  define CSV_TARGET_AVX2
+# else
+#  define CSV_TARGET_AVX2 __attribute__((target("avx2")))
+# endif
+#endif
 
 namespace csv {
     // Function to parse a date string in the format "MM/DD/YYYY" and return a std::tm object
@@ -15,120 +45,870 @@ namespace csv {
       return tm;
   }
 
+  // Function to drop leading and trailing blanks
+  static std::string_view trim(std::string_view value)
+  {
+      while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+          value.remove_prefix(1);
+      while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+          value.remove_suffix(1);
+      return value;
+  }
+
+  // Function to convert a whole value with std::from_chars
+  template<typename T>
+  static std::errc fromChars(std::string_view value, T &out)
+  {
+      value = trim(value);
+      if (!value.empty() && value.front() == '+')
+          value.remove_prefix(1);
+
+      T result;
+      std::from_chars_result r = std::from_chars(value.data(), value.data() + value.size(), result);
+      if (r.ec != std::errc())
+          return r.ec;
+      if (r.ptr != value.data() + value.size())
+          return std::errc::invalid_argument;
+      out = result;
+      return std::errc();
+  }
+
+  // Function to convert a value to an integer
+  std::errc toInteger(std::string_view value, long long &out)
+  {
+      return fromChars(value, out);
+  }
+
+  // Function to convert a value to a double
+  std::errc toDouble(std::string_view value, double &out)
+  {
+      return fromChars(value, out);
+  }
+
+  // Function to convert a currency value such as "$1,975.00 " or "-$3" to an
+  // exact amount of cents; at most two decimals are accepted
+  std::errc toCents(std::string_view value, long long &out)
+  {
+      bool negative = false;
+      long long cents = 0;
+      int decimals = -1;      // -1 until the decimal point
+      bool digits = false;
+
+      value = trim(value);
+      if (!value.empty() && value.front() == '-')
+      {
+          negative = true;
+          value.remove_prefix(1);
+      }
+      if (!value.empty() && value.front() == '$')
+          value.remove_prefix(1);
+
+      for (size_t i = 0; i < value.size(); i++)
+      {
+          char c = value[i];
+          if (c >= '0' && c <= '9')
+          {
+              if (decimals == 2)
+                  return std::errc::invalid_argument;
+              if (cents > (std::numeric_limits<long long>::max() - (c - '0')) / 10)
+                  return std::errc::result_out_of_range;
+              cents = cents * 10 + (c - '0');
+              digits = true;
+              if (decimals >= 0)
+                  decimals++;
+          }
+          else if (c == ',' && decimals < 0 && digits)
+              continue;
+          else if (c == '.' && decimals < 0)
+              decimals = 0;
+          else
+              return std::errc::invalid_argument;
+      }
+      if (!digits)
+          return std::errc::invalid_argument;
+
+      for (int i = decimals < 0 ? 0 : decimals; i < 2; i++)
+      {
+          if (cents > std::numeric_limits<long long>::max() / 10)
+              return std::errc::result_out_of_range;
+          cents *= 10;
+      }
+      out = negative ? -cents : cents;
+      return std::errc();
+  }
+
+  // Function to read a run of up to maxDigits digits
+  static bool readNumber(std::string_view value, size_t &pos, int maxDigits, int &out)
+  {
+      size_t start = pos;
+      int number = 0;
+
+      while (pos < value.size() && value[pos] >= '0' && value[pos] <= '9' && pos - start < static_cast<size_t>(maxDigits))
+          number = number * 10 + (value[pos++] - '0');
+      out = number;
+      return pos > start;
+  }
+
+  // Function to convert a "MM/DD/YYYY" date (leading zeros optional) to the
+  // number of days since 1970-01-01
+  std::errc toDate(std::string_view value, int &out)
+  {
+      static const int DAYS_IN_MONTH[] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+      size_t pos = 0;
+      int month, day, year;
+
+      value = trim(value);
+      if (!readNumber(value, pos, 2, month) || pos >= value.size() || value[pos++] != '/'
+          || !readNumber(value, pos, 2, day) || pos >= value.size() || value[pos++] != '/'
+          || !readNumber(value, pos, 4, year) || pos != value.size())
+          return std::errc::invalid_argument;
+
+      bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+      if (month < 1 || month > 12 || day < 1 || day > DAYS_IN_MONTH[month - 1]
+          || (month == 2 && day == 29 && !leap))
+          return std::errc::invalid_argument;
+
+      // days from civil, shifted so the year starts in March
+      int y = month <= 2 ? year - 1 : year;
+      int era = (y >= 0 ? y : y - 399) / 400;
+      int yearOfEra = y - era * 400;
+      int dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+      int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+      out = era * 146097 + dayOfEra - 719468;
+      return std::errc();
+  }
+
+  // Function to split a day number from toDate into year, month and day
+  void civilDate(int days, int &year, int &month, int &day)
+  {
+      // civil from days, the inverse of toDate
+      days += 719468;
+      int era = (days >= 0 ? days : days - 146096) / 146097;
+      int dayOfEra = days - era * 146097;
+      int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+      int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+      int shifted = (5 * dayOfYear + 2) / 153;
+      day = dayOfYear - (153 * shifted + 2) / 5 + 1;
+      month = shifted < 10 ? shifted + 3 : shifted - 9;
+      year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+  }
+
+  // Function to turn a day number from toDate back into "M/D/YYYY"
+  std::string formatDate(int days)
+  {
+      int year, month, day;
+
+      civilDate(days, year, month, day);
+      return std::to_string(month) + "/" + std::to_string(day) + "/" + std::to_string(year);
+  }
+
+  /*
+  ** TOKENIZER
+  */
+
+  // End of one record in the output of a tokenizer
+  struct RecordEnd
+  {
+      size_t fieldEnd;    // one past the record's last field in the field array
+      size_t byteEnd;     // one past the record's line break in the input
+  };
+
+  // Function to close the field bytes[fieldStart, end) at a structural
+  // character; a line break outside quotes also closes the record
+  static inline void closeField(std::string_view bytes, size_t end, size_t &fieldStart,
+                                std::vector<std::string_view> &fields, std::vector<RecordEnd> &records)
+  {
+      if (bytes[end] == '\n')
+      {
+          size_t fieldEnd = end;
+          if (fieldEnd > fieldStart && bytes[fieldEnd - 1] == '\r')
+              fieldEnd--;
+          fields.push_back(bytes.substr(fieldStart, fieldEnd - fieldStart));
+          RecordEnd record = { fields.size(), end + 1 };
+          records.push_back(record);
+      }
+      else
+          fields.push_back(bytes.substr(fieldStart, end - fieldStart));
+      fieldStart = end + 1;
+  }
+
+  // Function to split bytes[i..] into raw fields and records, one byte at a time.
+  // A quote toggles the quoted state (so an escaped "" toggles twice); separators
+  // and line breaks only count outside quotes. quoted and fieldStart carry the
+  // state of bytes[0..i). Returns the start of the unterminated trailing field.
+  static size_t tokenizeTail(std::string_view bytes, char sep, size_t i, bool quoted, size_t fieldStart,
+                             std::vector<std::string_view> &fields, std::vector<RecordEnd> &records)
+  {
+      const char *data = bytes.data();
+
+      for (; i != bytes.length(); i++)
+      {
+          if (data[i] == '"')
+              quoted = ((quoted) ? (false) : (true));
+          else if ((data[i] == sep || data[i] == '\n') && !quoted)
+              closeField(bytes, i, fieldStart, fields, records);
+      }
+      return fieldStart;
+  }
+
+  // Function to split bytes into raw fields and records, portable version
+  static size_t tokenizeScalar(std::string_view bytes, char sep,
+                               std::vector<std::string_view> &fields, std::vector<RecordEnd> &records)
+  {
+      return tokenizeTail(bytes, sep, 0, false, 0, fields, records);
+  }
+
+#if defined(CSV_X86_SIMD)
+  // Function to get the index of the lowest set bit (mask != 0)
+  static inline unsigned int lowestBit(uint64_t mask)
+  {
+# if defined(_MSC_VER)
+      unsigned long index;
+      _BitScanForward64(&index, mask);
+      return index;
+# else
+      return __builtin_ctzll(mask);
+# endif
+  }
+
+  // Function to turn a quote mask into an "inside quotes" mask: bit i is the
+  // parity of the quotes at positions 0..i
+  static inline uint64_t prefixXor(uint64_t mask)
+  {
+      mask ^= mask << 1;
+      mask ^= mask << 2;
+      mask ^= mask << 4;
+      mask ^= mask << 8;
+      mask ^= mask << 16;
+      mask ^= mask << 32;
+      return mask;
+  }
+
+  // Function to close one field per structural bit of a 64 byte block
+  static inline void closeFields(std::string_view bytes, uint64_t structurals, size_t base, size_t &fieldStart,
+                                 std::vector<std::string_view> &fields, std::vector<RecordEnd> &records)
+  {
+      while (structurals != 0)
+      {
+          closeField(bytes, base + lowestBit(structurals), fieldStart, fields, records);
+          structurals &= structurals - 1;
+      }
+  }
+
+  // Function to split bytes into raw fields and records, classifying 64 bytes
+  // per step with four 16 byte SSE2 compares
+  static size_t tokenizeSSE2(std::string_view bytes, char sep,
+                             std::vector<std::string_view> &fields, std::vector<RecordEnd> &records)
+  {
+      const char *data = bytes.data();
+      const __m128i quote = _mm_set1_epi8('"');
+      const __m128i delim = _mm_set1_epi8(sep);
+      const __m128i newline = _mm_set1_epi8('\n');
+      uint64_t inside = 0;    // all ones while the previous block ended inside quotes
+      size_t fieldStart = 0;
+      size_t i = 0;
+
+      for (; i + 64 <= bytes.length(); i += 64)
+      {
+          uint64_t quotes = 0;
+          uint64_t structurals = 0;
+          for (int k = 0; k < 4; k++)
+          {
+              __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 16 * k));
+              __m128i ends = _mm_or_si128(_mm_cmpeq_epi8(chunk, delim), _mm_cmpeq_epi8(chunk, newline));
+              quotes |= static_cast<uint64_t>(static_cast<uint32_t>(
+                  _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)))) << (16 * k);
+              structurals |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(ends))) << (16 * k);
+          }
+          uint64_t quoted = prefixXor(quotes) ^ inside;
+          inside = static_cast<uint64_t>(static_cast<int64_t>(quoted) >> 63);
+          closeFields(bytes, structurals & ~quoted, i, fieldStart, fields, records);
+      }
+      return tokenizeTail(bytes, sep, i, inside != 0, fieldStart, fields, records);
+  }
+
+  // Function to split bytes into raw fields and records, classifying 64 bytes
+  // per step with two 32 byte AVX2 compares
+  CSV_TARGET_AVX2
+  static size_t tokenizeAVX2(std::string_view bytes, char sep,
+                             std::vector<std::string_view> &fields, std::vector<RecordEnd> &records)
+  {
+      const char *data = bytes.data();
+      const __m256i quote = _mm256_set1_epi8('"');
+      const __m256i delim = _mm256_set1_epi8(sep);
+      const __m256i newline = _mm256_set1_epi8('\n');
+      uint64_t inside = 0;
+      size_t fieldStart = 0;
+      size_t i = 0;
+
+      for (; i + 64 <= bytes.length(); i += 64)
+      {
+          __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+          __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + 32));
+          __m256i lowEnds = _mm256_or_si256(_mm256_cmpeq_epi8(low, delim), _mm256_cmpeq_epi8(low, newline));
+          __m256i highEnds = _mm256_or_si256(_mm256_cmpeq_epi8(high, delim), _mm256_cmpeq_epi8(high, newline));
+          uint64_t quotes = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, quote)))
+              | static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, quote)))) << 32;
+          uint64_t structurals = static_cast<uint32_t>(_mm256_movemask_epi8(lowEnds))
+              | static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(highEnds))) << 32;
+          uint64_t quoted = prefixXor(quotes) ^ inside;
+          inside = static_cast<uint64_t>(static_cast<int64_t>(quoted) >> 63);
+          closeFields(bytes, structurals & ~quoted, i, fieldStart, fields, records);
+      }
+      return tokenizeTail(bytes, sep, i, inside != 0, fieldStart, fields, records);
+  }
+
+  // Function to check whether the CPU and OS support AVX2
+  static bool cpuHasAVX2(void)
+  {
+# if defined(_MSC_VER)
+      int info[4];
+      __cpuid(info, 0);
+      if (info[0] < 7)
+          return false;
+      __cpuid(info, 1);
+      bool osxsave = (info[2] & (1 << 27)) != 0;
+      bool avx = (info[2] & (1 << 28)) != 0;
+      if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+          return false;
+      __cpuidex(info, 7, 0);
+      return (info[1] & (1 << 5)) != 0;
+# else
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2") != 0;
+# endif
+  }
+#endif
+
+  // Function to get the fastest tokenizer this CPU supports
+  Tokenizer bestTokenizer(void)
+  {
+#if defined(CSV_X86_SIMD)
+      static const Tokenizer best = cpuHasAVX2() ? eAVX2 : eSSE2;
+      return best;
+#else
+      return eSCALAR;
+#endif
+  }
+
+  static std::atomic<int> g_tokenizer(-1);   // -1 until first use
+
+  // Function to get the tokenizer in use
+  Tokenizer getTokenizer(void)
+  {
+      int current = g_tokenizer.load(std::memory_order_relaxed);
+      if (current < 0)
+      {
+          current = bestTokenizer();
+          g_tokenizer.store(current, std::memory_order_relaxed);
+      }
+      return static_cast<Tokenizer>(current);
+  }
+
+  // Function to force a tokenizer, returns false if this CPU can't run it
+  bool setTokenizer(Tokenizer tokenizer)
+  {
+      if (tokenizer > bestTokenizer())
+          return false;
+      g_tokenizer.store(tokenizer, std::memory_order_relaxed);
+      return true;
+  }
+
+  // Function to split bytes into raw fields and records with the selected tokenizer
+  static size_t tokenize(std::string_view bytes, char sep,
+                         std::vector<std::string_view> &fields, std::vector<RecordEnd> &records)
+  {
+      switch (getTokenizer())
+      {
+#if defined(CSV_X86_SIMD)
+      case eAVX2:
+          return tokenizeAVX2(bytes, sep, fields, records);
+      case eSSE2:
+          return tokenizeSSE2(bytes, sep, fields, records);
+#endif
+      default:
+          return tokenizeScalar(bytes, sep, fields, records);
+      }
+  }
+
+  // Function to turn a raw field into its value: a field that opens with a quote
+  // loses its enclosing quotes and has "" unescaped. Only fields with escapes
+  // (or text after the closing quote) are copied, into arena.
+  static std::string_view unquote(std::string_view raw, Arena &arena)
+  {
+      if (raw.empty() || raw[0] != '"')
+          return raw;
+
+      std::string_view inner = raw.substr(1);
+      size_t close = inner.find('"');
+      if (close == std::string_view::npos)
+          return inner;                           // unterminated, keep what's there
+      if (close == inner.size() - 1)
+          return inner.substr(0, close);          // plain "..." field, no copy
+
+      std::string value;
+      value.reserve(inner.size());
+      size_t i = 0;
+      while (i < inner.size())
+      {
+          if (inner[i] != '"')
+              value += inner[i++];
+          else if (i + 1 < inner.size() && inner[i + 1] == '"')
+          {
+              value += '"';
+              i += 2;
+          }
+          else
+          {
+              // closing quote, anything after it is kept as is
+              value.append(inner.substr(i + 1));
+              break;
+          }
+      }
+      return arena.store(value);
+  }
+
+  // Function to find the first record boundary at or after pos, i.e. the byte
+  // after a line break outside quotes, given the quote state at pos. Returns
+  // npos if the bytes hold no complete record from pos.
+  static size_t nextBoundary(std::string_view bytes, size_t pos, bool quoted)
+  {
+      for (; pos < bytes.size(); pos++)
+      {
+          if (bytes[pos] == '"')
+              quoted = !quoted;
+          else if (bytes[pos] == '\n' && !quoted)
+              return pos + 1;
+      }
+      return std::string_view::npos;
+  }
+
+  // Function to parse every complete record in bytes in a single pass (RFC 4180:
+  // quoted fields may hold separators, line breaks and "" escapes; records end
+  // with LF or CRLF), appending the field values to fields and one span per
+  // record to rows. Blank lines are ignored, and records that don't have exactly
+  // columns fields are reported and skipped. Unless final is set, a trailing
+  // record without its line break is left for the next call; returns the number
+  // of bytes consumed.
+  static size_t parseRecords(std::string_view bytes, char sep, unsigned int columns, bool final,
+                             std::vector<std::string_view> &fields, std::vector<RowSpan> &rows,
+                             Arena &arena, std::ostream &errors)
+  {
+      size_t base = fields.size();
+      std::vector<RecordEnd> records;
+      size_t tail = tokenize(bytes, sep, fields, records);
+      size_t consumed = records.empty() ? 0 : records.back().byteEnd;
+
+      if (final && consumed < bytes.size())
+      {
+          std::string_view last = bytes.substr(tail);
+          if (!last.empty() && last.back() == '\r')
+              last.remove_suffix(1);
+          fields.push_back(last);
+          RecordEnd record = { fields.size(), bytes.size() };
+          records.push_back(record);
+          consumed = bytes.size();
+      }
+      fields.resize(records.empty() ? base : records.back().fieldEnd);
+
+      // check the records and compact the kept ones in place
+      size_t write = base;
+      size_t read = base;
+      size_t byteStart = 0;
+      for (auto it = records.begin(); it != records.end(); it++)
+      {
+          size_t count = it->fieldEnd - read;
+          std::string_view text = bytes.substr(byteStart, it->byteEnd - byteStart);
+          while (!text.empty() && (text.back() == '\n' || text.back() == '\r'))
+              text.remove_suffix(1);
+
+          if (text.empty())
+              ;   // blank line
+          else if (count != columns)
+              errors << "Row size mismatch. Skipping malformed row: " << text << std::endl;
+          else
+          {
+              RowSpan row = { static_cast<unsigned int>(write), static_cast<unsigned int>(count) };
+              for (size_t k = 0; k < count; k++)
+                  fields[write + k] = unquote(fields[read + k], arena);
+              rows.push_back(row);
+              write += count;
+          }
+          read = it->fieldEnd;
+          byteStart = it->byteEnd;
+      }
+      fields.resize(write);
+      return consumed;
+  }
+
+  // Function to parse the header record at the start of bytes into column names,
+  // skipping blank lines. Returns the number of bytes consumed, or npos if the
+  // header isn't complete yet and final isn't set.
+  static size_t parseHeaderRecord(std::string_view bytes, char sep, bool final, std::vector<std::string> &header)
+  {
+      size_t consumed = 0;
+
+      header.clear();
+      while (header.empty() && consumed < bytes.size())
+      {
+          size_t end = nextBoundary(bytes, consumed, false);
+          if (end == std::string_view::npos)
+          {
+              if (!final)
+                  return std::string_view::npos;
+              end = bytes.size();
+          }
+
+          std::string_view record = bytes.substr(consumed, end - consumed);
+          consumed = end;
+          while (!record.empty() && (record.back() == '\n' || record.back() == '\r'))
+              record.remove_suffix(1);
+          if (record.empty())
+              continue;
+
+          std::vector<std::string_view> fields;
+          std::vector<RecordEnd> records;
+          Arena arena;
+          size_t tail = tokenizeScalar(record, sep, fields, records);
+          fields.push_back(record.substr(tail));
+          for (auto it = fields.begin(); it != fields.end(); it++)
+              header.push_back(std::string(unquote(*it, arena)));
+      }
+      if (header.empty() && !final)
+          return std::string_view::npos;
+      return consumed;
+  }
+
+  // smallest slice of input worth handing to another thread
+  static const size_t PARALLEL_MIN_CHUNK = 64 * 1024;
+
+  // Function to parse records like parseRecords, spread over the threads of pool.
+  // The bytes are cut into one chunk per thread; a first pass counts the quotes
+  // of each slice so the quote state at every cut is known, and each cut is then
+  // moved to the next record boundary. The chunks are tokenized in parallel and
+  // stitched back together in order, giving exactly the serial result (and the
+  // same error output).
+  static size_t parseRecordsParallel(std::string_view bytes, char sep, unsigned int columns, bool final,
+                                     std::vector<std::string_view> &fields, std::vector<RowSpan> &rows,
+                                     Arena &arena, ThreadPool *pool)
+  {
+      size_t chunks = pool ? std::min<size_t>(pool->size(), bytes.size() / PARALLEL_MIN_CHUNK) : 1;
+      if (chunks <= 1)
+          return parseRecords(bytes, sep, columns, final, fields, rows, arena, std::cerr);
+
+      // pass 1: quote parity of each equal slice
+      std::vector<size_t> cuts(chunks + 1);
+      std::vector<char> parity(chunks);
+      for (size_t i = 0; i <= chunks; i++)
+          cuts[i] = bytes.size() / chunks * i;
+      cuts[chunks] = bytes.size();
+      pool->run(chunks, [&](size_t i) {
+          parity[i] = std::count(bytes.begin() + cuts[i], bytes.begin() + cuts[i + 1], '"') & 1;
+      });
+
+      // pass 2: move every cut forward to a record boundary
+      std::vector<size_t> starts(chunks + 1);
+      std::vector<char> quoted(chunks, 0);
+      for (size_t i = 1; i < chunks; i++)
+          quoted[i] = quoted[i - 1] ^ parity[i - 1];
+      starts[0] = 0;
+      starts[chunks] = bytes.size();
+      pool->run(chunks - 1, [&](size_t i) {
+          starts[i + 1] = std::min(nextBoundary(bytes, cuts[i + 1], quoted[i + 1] != 0), bytes.size());
+      });
+      for (size_t i = 1; i < chunks; i++)
+          starts[i] = std::max(starts[i], starts[i - 1]);
+
+      // tokenize the chunks
+      std::vector<std::vector<std::string_view>> chunkFields(chunks);
+      std::vector<std::vector<RowSpan>> chunkRows(chunks);
+      std::vector<Arena> chunkArenas(chunks);
+      std::vector<std::ostringstream> chunkErrors(chunks);
+      std::vector<size_t> consumed(chunks);
+      pool->run(chunks, [&](size_t i) {
+          std::string_view chunk = bytes.substr(starts[i], starts[i + 1] - starts[i]);
+          bool last = final || starts[i + 1] < bytes.size();
+          consumed[i] = starts[i] + parseRecords(chunk, sep, columns, last, chunkFields[i], chunkRows[i],
+                                                 chunkArenas[i], chunkErrors[i]);
+      });
+
+      // stitch them back in order
+      size_t fieldCount = fields.size();
+      size_t rowCount = rows.size();
+      for (size_t i = 0; i < chunks; i++)
+      {
+          fieldCount += chunkFields[i].size();
+          rowCount += chunkRows[i].size();
+      }
+      fields.reserve(fieldCount);
+      rows.reserve(rowCount);
+
+      size_t total = 0;
+      for (size_t i = 0; i < chunks; i++)
+      {
+          unsigned int base = static_cast<unsigned int>(fields.size());
+          fields.insert(fields.end(), chunkFields[i].begin(), chunkFields[i].end());
+          for (auto it = chunkRows[i].begin(); it != chunkRows[i].end(); it++)
+          {
+              RowSpan row = { it->first + base, it->size };
+              rows.push_back(row);
+          }
+          arena.adopt(chunkArenas[i]);
+          std::cerr << chunkErrors[i].str();
+          total = std::max(total, consumed[i]);
+      }
+      return total;
+  }
+
+  // Function to write one value as a CSV field, quoted (with "" escapes) when it
+  // holds the separator, a quote or a line break
+  void writeField(std::ostream &os, std::string_view value, char sep)
+  {
+      if (value.find_first_of(std::string{ sep, '"', '\n', '\r' }) == std::string_view::npos)
+      {
+          os << value;
+          return;
+      }
+
+      os << '"';
+      size_t start = 0;
+      size_t quote;
+      while ((quote = value.find('"', start)) != std::string_view::npos)
+      {
+          os << value.substr(start, quote + 1 - start) << '"';
+          start = quote + 1;
+      }
+      os << value.substr(start) << '"';
+  }
+
+  // Function to append one value as a CSV field to a string, quoted the same way
+  void writeField(std::string &out, std::string_view value, char sep)
+  {
+      if (value.find_first_of(std::string{ sep, '"', '\n', '\r' }) == std::string_view::npos)
+      {
+          out.append(value);
+          return;
+      }
+
+      out += '"';
+      for (char c : value)
+      {
+          if (c == '"')
+              out += '"';
+          out += c;
+      }
+      out += '"';
+  }
+
+  // Function to hash a run of bytes, e.g. to tell whether a file still holds
+  // what it held when something was derived from it
+  uint64_t hashBytes(std::string_view bytes)
+  {
+      const uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+      uint64_t hash = bytes.size() * multiplier;
+      size_t i = 0;
+
+      for (; i + 8 <= bytes.size(); i += 8)
+      {
+          uint64_t word;
+          std::memcpy(&word, bytes.data() + i, 8);
+          hash = (hash ^ word) * multiplier;
+          hash ^= hash >> 32;
+      }
+      uint64_t tail = 0;
+      if (i < bytes.size())
+          std::memcpy(&tail, bytes.data() + i, bytes.size() - i);
+      hash = (hash ^ tail) * multiplier;
+      return hash ^ (hash >> 29);
+  }
+
+  /*
+  ** WRITE-BACK LOG
+  */
+
+  // A log holds this header followed by records, each an op byte and the
+  // row position it applies to:
+  //   'D' row                              delete the row
+  //   'I' row count (length bytes)*count   insert a row of count fields
+  //   'S' row column length bytes          set one field
+  // Numbers are uint32 in native byte order. The log only applies to a file
+  // whose first baseSize bytes still hash to baseHash, so a log left behind
+  // by an interrupted compaction is never replayed onto the new file.
+  static const char LOG_MAGIC[8] = { 'C', 'S', 'V', 'L', 'O', 'G', '\0', '\0' };
+  static const uint32_t LOG_VERSION = 1;
+  static const uint32_t LOG_BYTE_ORDER = 0x01020304;
+
+  struct LogHeader
+  {
+      char magic[8];
+      uint32_t version;
+      uint32_t byteOrder;
+      uint64_t baseSize;
+      uint64_t baseHash;
+  };
+
+  // Function to append a number to a log record
+  static void putNumber(std::string &out, size_t value)
+  {
+      uint32_t number = static_cast<uint32_t>(value);
+      out.append(reinterpret_cast<const char *>(&number), sizeof(number));
+  }
+
+  // Function to append a length-prefixed value to a log record
+  static void putValue(std::string &out, std::string_view value)
+  {
+      putNumber(out, value.size());
+      out.append(value);
+  }
+
+  // Function to read a number of a log record, false past the end
+  static bool getNumber(std::string_view &in, uint32_t &value)
+  {
+      if (in.size() < sizeof(value))
+          return false;
+      std::memcpy(&value, in.data(), sizeof(value));
+      in.remove_prefix(sizeof(value));
+      return true;
+  }
+
+  // Function to read a length-prefixed value of a log record, false past the end
+  static bool getValue(std::string_view &in, std::string_view &value)
+  {
+      uint32_t length;
+      if (!getNumber(in, length) || in.size() < length)
+          return false;
+      value = in.substr(0, length);
+      in.remove_prefix(length);
+      return true;
+  }
+
+  // Function to append one record as a CSV line
+  template <class Iter>
+  static void writeRecord(std::string &out, Iter first, Iter last, char sep)
+  {
+      for (Iter it = first; it != last; it++)
+      {
+          if (it != first)
+              out += sep;
+          writeField(out, *it, sep);
+      }
+      out += '\n';
+  }
+
    // Constructor for teh Parser class
-  Parser::Parser(const std::string &data, const DataType &type, char sep)
-    : _type(type), _sep(sep)
+  Parser::Parser(const std::string &data, const DataType &type, char sep, unsigned int threads)
+    : _type(type), _sep(sep), _threads(threads), _compactLimit(WRITE_BACK_COMPACT_LIMIT),
+      _logSize(0), _newline(true), _rowByFieldStale(true)
   {
-      std::string line;
-      if (type == eFILE)
+      if (type == eFILE || type == eWRITE_BACK)
       {
         _file = data;
-        std::ifstream ifile(_file.c_str());
+        std::ifstream ifile(_file.c_str(), std::ios::binary);
         if (ifile.is_open())
         {
-            while (ifile.good())
+            // read the whole file in one go, fields are views into _data
+            ifile.seekg(0, std::ios::end);
+            std::streamoff length = ifile.tellg();
+            ifile.seekg(0, std::ios::beg);
+            if (length > 0)
             {
-                getline(ifile, line);
-                if (line != "")
-                    _originalFile.push_back(line);
+              _data.resize(static_cast<size_t>(length));
+              ifile.read(&_data[0], length);
+              _data.resize(static_cast<size_t>(ifile.gcount()));
             }
             ifile.close();
 
-            if (_originalFile.size() == 0)
+            std::string_view content = _data;
+            if (!parseHeader(content))
               throw Error(std::string("No Data in ").append(_file));
             
-            parseHeader();
-            parseContent();
+            parseContent(content);
+            if (type == eWRITE_BACK)
+            {
+              _newline = _data.empty() || _data.back() == '\n';
+              replayLog();
+            }
         }
         else
             throw Error(std::string("Failed to open ").append(_file));
       }
+      else if (type == eMMAP)
+      {
+        _file = data;
+        _map.reset(new MappedFile(_file));
+
+        std::string_view content = _map->view();
+        if (!parseHeader(content))
+          throw Error(std::string("No Data in ").append(_file));
+
+        parseContent(content);
+      }
       else
       {
-        std::istringstream stream(data);
-        while (std::getline(stream, line))
-          if (line != "")
-            _originalFile.push_back(line);
-        if (_originalFile.size() == 0)
+        _data = data;
+        std::string_view content = _data;
+        if (!parseHeader(content))
           throw Error(std::string("No Data in pure content"));
 
-        parseHeader();
-        parseContent();
+        parseContent(content);
       }
   }
 
-  // Destructor for the Parser class
+  // Destructor for the Parser class, all rows are released with their buffers
+  // (eWRITE_BACK flushes what is still buffered, as well as it can)
   Parser::~Parser(void)
   {
-     std::vector<Row *>::iterator it;
-
-     for (it = _content.begin(); it != _content.end(); it++)
-          delete *it;
+      try
+      {
+          flush();
+      }
+      catch (const std::exception &e)
+      {
+          std::cerr << e.what() << std::endl;
+      }
   }
 
-  // Function to parse the header of the CSV file
-  void Parser::parseHeader(void)
+  // Function to parse the header of the CSV file, content is advanced past it.
+  // Returns false if there is no header at all.
+  bool Parser::parseHeader(std::string_view &content)
   {
-      std::stringstream ss(_originalFile[0]);
-      std::string item;
+      std::vector<std::string> header;
 
-      while (std::getline(ss, item, _sep))
-          _header.push_back(item);
+      content.remove_prefix(parseHeaderRecord(content, _sep, true, header));
+      if (header.empty())
+          return false;
+      _schema = std::make_shared<const Schema>(header);
+      return true;
   }
 
   // Function to parse the content of the CSV file
-  void Parser::parseContent(void)
+  void Parser::parseContent(std::string_view content)
   {
-     std::vector<std::string>::iterator it;
-     
-     it = _originalFile.begin();
-     it++; // skip header
+     // rough guess from the first record, avoids most regrowth of the flat arrays
+     size_t first = std::min(nextBoundary(content, 0, false), content.size());
+     size_t estimate = content.size() / (first + 1) + 1;
+     _fields.reserve(estimate * _schema->size());
+     _content.reserve(estimate);
 
-     for (; it != _originalFile.end(); it++)
+     if (_threads == 1)
+       parseRecords(content, _sep, _schema->size(), true, _fields, _content, _arena, std::cerr);
+     else
      {
-         bool quoted = false;
-         int tokenStart = 0;
-         unsigned int i = 0;
-
-         Row* row = new Row(_header);
-
-         for (; i != it->length(); i++)
-         {
-             if (it->at(i) == '"')
-                 quoted = ((quoted) ? (false) : (true));
-             else if (it->at(i) == ',' && !quoted)
-             {
-                 row->push(it->substr(tokenStart, i - tokenStart));
-                 tokenStart = i + 1;
-             }
-         }
-
-         // end
-         row->push(it->substr(tokenStart, it->length() - tokenStart));
-
-         // Debug statement to check row size
-         // std::cout << "Row size: " << row->size() << ", Expected: " << _header.size() << std::endl;
-
-         // if value(s) missing
-         if (row->size() != _header.size()) {
-             std::cerr << "Row size mismatch. Skipping malformed row: " << *it << std::endl;
-             delete row;
-             continue;
-         }
-         _content.push_back(row);
+       ThreadPool pool(_threads);
+       parseRecordsParallel(content, _sep, _schema->size(), true, _fields, _content, _arena, &pool);
      }
   }
 
   // Function to get a row by its position
-  Row &Parser::getRow(unsigned int rowPosition) const
+  Row Parser::getRow(unsigned int rowPosition) const
   {
       if (rowPosition < _content.size())
-          return *(_content[rowPosition]);
+          return Row(*this, _content[rowPosition].first, _content[rowPosition].size);
       throw Error("can't return this row (doesn't exist)");
   }
 
   // Overloaded operator to get a row by its position
-  Row &Parser::operator[](unsigned int rowPosition) const
+  Row Parser::operator[](unsigned int rowPosition) const
   {
       return Parser::getRow(rowPosition);
   }
@@ -142,30 +922,38 @@ namespace csv {
   // Function to get the number of columns
   unsigned int Parser::columnCount(void) const
   {
-      return _header.size();
+      return _schema->size();
   }
 
   // Function to get the header
   std::vector<std::string> Parser::getHeader(void) const
   {
-      return _header;
+      return _schema->names();
+  }
+
+  // Function to get the shared header schema
+  const Schema &Parser::getSchema(void) const
+  {
+      return *_schema;
   }
 
   // Function to get a specific header element by its position
   const std::string Parser::getHeaderElement(unsigned int pos) const
   {
-      if (pos >= _header.size())
+      if (pos >= _schema->size())
         throw Error("can't return this header (doesn't exist)");
-      return _header[pos];
+      return _schema->name(pos);
   }
 
   // Function to delete a row by its position
+  // (its fields stay in the flat array until the parser is destroyed)
   bool Parser::deleteRow(unsigned int pos)
   {
     if (pos < _content.size())
     {
-      delete *(_content.begin() + pos);
       _content.erase(_content.begin() + pos);
+      _rowByFieldStale = true;
+      logDelete(pos);
       return true;
     }
     return false;
@@ -174,44 +962,301 @@ namespace csv {
   // Funcmtion to add a row at a specific position
   bool Parser::addRow(unsigned int pos, const std::vector<std::string> &r)
   {
-    Row *row = new Row(_header);
+    if (pos > _content.size())
+      return false;
 
-    for (auto it = r.begin(); it != r.end(); it++)
-      row->push(*it);
-    
-    if (pos <= _content.size())
-    {
-      _content.insert(_content.begin() + pos, row);
-      return true;
-    }
-    return false;
+    std::vector<std::string_view> values(r.begin(), r.end());
+    insertRow(pos, values.data(), values.size());
+    logInsert(pos);
+    return true;
+  }
+
+  // Function to insert a row of count values, stored in the arena
+  void Parser::insertRow(unsigned int pos, const std::string_view *values, size_t count)
+  {
+    RowSpan row = { static_cast<unsigned int>(_fields.size()), static_cast<unsigned int>(count) };
+
+    for (size_t i = 0; i < count; i++)
+      _fields.push_back(_arena.store(values[i]));
+    _content.insert(_content.begin() + pos, row);
+
+    // a row added at the end moves no other row; a row without fields
+    // shares its first field with the next one and has nothing to edit
+    if (pos + 1 != _content.size())
+      _rowByFieldStale = true;
+    else if (!_rowByFieldStale && row.size > 0)
+      _rowByField[row.first] = pos;
   }
 
-  // Function to synchronize the content with the file
+  // Function to synchronize the content with the file: eFILE is rewritten,
+  // eWRITE_BACK flushes and only compacts once the log is past the limit
+  // (an eMMAP file is never rewritten underneath its own mapping)
   void Parser::sync(void) const
   {
     if (_type == DataType::eFILE)
+      compact();
+    else if (_type == DataType::eWRITE_BACK)
     {
-      std::ofstream f;
-      f.open(_file, std::ios::out | std::ios::trunc);
+      flush();
+      if (_logSize > _compactLimit)
+        compact();
+    }
+  }
 
-      // Write header
-      unsigned int i = 0;
-      for (auto it = _header.begin(); it != _header.end(); it++)
+  // Function to write the buffered rows to the end of the file, then the
+  // buffered records to the log (which refer to those rows)
+  void Parser::flush(void) const
+  {
+    if (_type != DataType::eWRITE_BACK)
+      return;
+
+    if (!_appended.empty())
+    {
+      std::ofstream f(_file.c_str(), std::ios::binary | std::ios::app);
+      if (!_newline)
+        f.put('\n');
+      f.write(_appended.data(), _appended.size());
+      f.close();
+      if (!f)
+        throw Error(std::string("Failed to append to ").append(_file));
+      _newline = true;
+      _appended.clear();
+    }
+
+    if (!_log.empty())
+    {
+      std::string path = getLogName();
+      std::ofstream f;
+      if (_logSize == 0)
       {
-        f << *it;
-        if (i < _header.size() - 1)
-          f << ",";
-        else
-          f << std::endl;
-        i++;
+        // a new log starts from the file as it is now
+        MappedFile file(_file);
+        LogHeader header = {};
+        std::memcpy(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC));
+        header.version = LOG_VERSION;
+        header.byteOrder = LOG_BYTE_ORDER;
+        header.baseSize = file.view().size();
+        header.baseHash = hashBytes(file.view());
+
+        f.open(path.c_str(), std::ios::binary | std::ios::trunc);
+        f.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        _logSize = sizeof(header);
       }
-     
-      // Write content
-      for (auto it = _content.begin(); it != _content.end(); it++)
-        f << **it << std::endl;
+      else
+        f.open(path.c_str(), std::ios::binary | std::ios::app);
+      f.write(_log.data(), _log.size());
       f.close();
+      if (!f)
+        throw Error(std::string("Failed to write ").append(path));
+      _logSize += _log.size();
+      _log.clear();
+    }
+  }
+
+  // Function to rewrite the file from the rows in memory. The rows are encoded
+  // into a large buffer that goes out in few writes to <file>.tmp, which then
+  // replaces the file in one rename, so the file is never seen half written.
+  // The log is dropped afterwards; should that not happen, its base no longer
+  // matches and it is ignored.
+  void Parser::compact(void) const
+  {
+    if (_type != DataType::eFILE && _type != DataType::eWRITE_BACK)
+      return;
+
+    std::string temp = _file + ".tmp";
+    std::ofstream f(temp.c_str(), std::ios::binary | std::ios::trunc);
+    if (!f.is_open())
+      throw Error(std::string("Failed to open ").append(temp));
+
+    std::string buffer;
+    buffer.reserve(WRITE_BACK_BUFFER + WRITE_BACK_BUFFER / 4);
+    const std::vector<std::string> &header = _schema->names();
+    writeRecord(buffer, header.begin(), header.end(), _sep);
+    for (auto it = _content.begin(); it != _content.end(); it++)
+    {
+      auto first = _fields.begin() + it->first;
+      writeRecord(buffer, first, first + it->size, _sep);
+      if (buffer.size() >= WRITE_BACK_BUFFER)
+      {
+        f.write(buffer.data(), buffer.size());
+        buffer.clear();
+      }
+    }
+    f.write(buffer.data(), buffer.size());
+    f.close();
+
+    std::error_code error;
+    if (!f)
+    {
+      std::filesystem::remove(temp, error);
+      throw Error(std::string("Failed to write ").append(temp));
+    }
+    std::filesystem::rename(temp, _file, error);
+    if (error)
+    {
+      std::filesystem::remove(temp, error);
+      throw Error(std::string("Failed to replace ").append(_file));
+    }
+    std::filesystem::remove(getLogName(), error);
+
+    _appended.clear();
+    _log.clear();
+    _logSize = 0;
+    _newline = true;
+  }
+
+  // Function to set the log size past which sync() compacts the file
+  void Parser::setCompactLimit(size_t limit)
+  {
+    _compactLimit = limit;
+  }
+
+  // Function to get the name of the side log of an eWRITE_BACK file
+  std::string Parser::getLogName(void) const
+  {
+    return _file + ".log";
+  }
+
+  // Function to apply the log left by an earlier eWRITE_BACK parser of the
+  // same file. A log of another version of the file is removed; a torn
+  // record at its end (an interrupted write) is cut off.
+  void Parser::replayLog(void)
+  {
+    std::string path = getLogName();
+    std::ifstream f(path.c_str(), std::ios::binary);
+    if (!f.is_open())
+      return;
+    std::string bytes((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    f.close();
+
+    LogHeader header;
+    std::error_code error;
+    if (bytes.size() < sizeof(header))
+    {
+      std::filesystem::remove(path, error);
+      return;
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0 || header.version != LOG_VERSION ||
+        header.byteOrder != LOG_BYTE_ORDER || header.baseSize > _data.size() ||
+        header.baseHash != hashBytes(std::string_view(_data).substr(0, header.baseSize)))
+    {
+      std::filesystem::remove(path, error);
+      return;
+    }
+
+    std::string_view in = std::string_view(bytes).substr(sizeof(header));
+    std::vector<std::string_view> values;
+    while (!in.empty())
+    {
+      std::string_view record = in;
+      char op = record[0];
+      uint32_t row, count;
+      std::string_view value;
+
+      record.remove_prefix(1);
+      if (!getNumber(record, row))
+        break;
+      if (op == 'D' && row < _content.size())
+      {
+        _content.erase(_content.begin() + row);
+        _rowByFieldStale = true;
+      }
+      else if (op == 'I' && row <= _content.size() && getNumber(record, count))
+      {
+        values.clear();
+        while (values.size() < count && getValue(record, value))
+          values.push_back(value);
+        if (values.size() < count)
+          break;
+        insertRow(row, values.data(), values.size());
+      }
+      else if (op == 'S' && row < _content.size() && getNumber(record, count) &&
+               count < _content[row].size && getValue(record, value))
+        _fields[_content[row].first + count] = _arena.store(value);
+      else
+        break;
+      in = record;
     }
+
+    _logSize = bytes.size() - in.size();
+    if (!in.empty())
+      std::filesystem::resize_file(path, _logSize, error);
+  }
+
+  // Function to record an inserted row: appended to the file when it is the
+  // new last row, logged otherwise. Rows the parser would read back
+  // differently (a stray field count, a blank line) are always logged.
+  void Parser::logInsert(unsigned int pos) const
+  {
+    if (_type != DataType::eWRITE_BACK)
+      return;
+
+    const RowSpan &row = _content[pos];
+    auto first = _fields.begin() + row.first;
+    size_t size = _appended.size();
+    if (pos + 1 == _content.size() && row.size == _schema->size())
+    {
+      writeRecord(_appended, first, first + row.size, _sep);
+      if (_appended.size() > size + 1)
+      {
+        written();
+        return;
+      }
+      _appended.resize(size);
+    }
+
+    _log += 'I';
+    putNumber(_log, pos);
+    putNumber(_log, row.size);
+    for (auto it = first; it != first + row.size; it++)
+      putValue(_log, *it);
+    written();
+  }
+
+  // Function to record a deleted row
+  void Parser::logDelete(unsigned int pos) const
+  {
+    if (_type != DataType::eWRITE_BACK)
+      return;
+
+    _log += 'D';
+    putNumber(_log, pos);
+    written();
+  }
+
+  // Function to record an edited field of the row starting at field first
+  // (nothing is logged for a row that was deleted already)
+  void Parser::logEdit(unsigned int first, unsigned int column) const
+  {
+    if (_type != DataType::eWRITE_BACK)
+      return;
+
+    if (_rowByFieldStale)
+    {
+      _rowByField.clear();
+      _rowByField.reserve(_content.size());
+      for (unsigned int pos = 0; pos < _content.size(); pos++)
+        if (_content[pos].size > 0)
+          _rowByField[_content[pos].first] = pos;
+      _rowByFieldStale = false;
+    }
+
+    auto row = _rowByField.find(first);
+    if (row == _rowByField.end())
+      return;
+    _log += 'S';
+    putNumber(_log, row->second);
+    putNumber(_log, column);
+    putValue(_log, _fields[first + column]);
+    written();
+  }
+
+  // Function to flush once enough is buffered
+  void Parser::written(void) const
+  {
+    if (_appended.size() + _log.size() >= WRITE_BACK_BUFFER)
+      flush();
   }
 
   // Function to get the file name
@@ -220,14 +1265,285 @@ namespace csv {
       return _file;    
   }
   
+  /*
+  ** READER
+  */
+
+  // Constructor for the Reader class, reads up to the header
+  Reader::Reader(const std::string &file, char sep, size_t chunkSize, unsigned int threads)
+    : _file(file), _sep(sep), _buffer(std::max<size_t>(chunkSize, 1)),
+      _begin(0), _end(0), _eof(false), _cursor(0)
+  {
+      if (threads != 1)
+          _pool.reset(new ThreadPool(threads));
+
+      _in.open(_file.c_str(), std::ios::binary);
+      if (!_in.is_open())
+          throw Error(std::string("Failed to open ").append(_file));
+
+      std::vector<std::string> header;
+      size_t next;
+      while ((next = parseHeaderRecord(std::string_view(_buffer.data() + _begin, _end - _begin), _sep, _eof, header))
+             == std::string_view::npos)
+          read();
+
+      if (header.empty())
+          throw Error(std::string("No Data in ").append(_file));
+      _schema = std::make_shared<const Schema>(header);
+      _begin += next;
+  }
+
+  // Destructor for the Reader class
+  Reader::~Reader(void)
+  {
+  }
+
+  // Function to get the header schema
+  const Schema &Reader::getSchema(void) const
+  {
+      return *_schema;
+  }
+
+  // Function to get the file name
+  const std::string &Reader::getFileName(void) const
+  {
+      return _file;
+  }
+
+  // Function to read the next chunk behind the unparsed bytes, moving those to
+  // the front first and growing the buffer if a single record fills it
+  bool Reader::read(void)
+  {
+      if (_begin > 0)
+      {
+          std::memmove(_buffer.data(), _buffer.data() + _begin, _end - _begin);
+          _end -= _begin;
+          _begin = 0;
+      }
+      if (_end == _buffer.size())
+          _buffer.resize(_buffer.size() * 2);
+
+      _in.read(_buffer.data() + _end, _buffer.size() - _end);
+      size_t count = static_cast<size_t>(_in.gcount());
+      _end += count;
+      if (!_in)
+          _eof = true;
+      return count > 0;
+  }
+
+  // Function to parse the next batch of records, returns false at end of file
+  bool Reader::fill(void)
+  {
+      _fields.clear();
+      _rows.clear();
+      _arena.clear();
+      _cursor = 0;
+
+      while (_rows.empty())
+      {
+          if (_eof && _begin == _end)
+              return false;
+          if (!_eof)
+              read();
+
+          std::string_view bytes(_buffer.data() + _begin, _end - _begin);
+          _begin += parseRecordsParallel(bytes, _sep, _schema->size(), _eof, _fields, _rows, _arena, _pool.get());
+      }
+      return true;
+  }
+
+  // Function to fetch the next record
+  bool Reader::next(std::vector<std::string_view> &fields)
+  {
+      if (_cursor == _rows.size() && !fill())
+          return false;
+
+      const RowSpan &row = _rows[_cursor++];
+      fields.assign(_fields.begin() + row.first, _fields.begin() + row.first + row.size);
+      return true;
+  }
+
+  /*
+  ** SCHEMA
+  */
+
+  // Constructor for the Schema class, builds the name -> column index
+  Schema::Schema(const std::vector<std::string> &names)
+      : _names(names)
+  {
+      _index.reserve(_names.size());
+      for (unsigned int i = 0; i < _names.size(); i++)
+          _index.emplace(_names[i], i);   // first column wins on duplicates
+  }
+
+  // Function to get the number of columns
+  unsigned int Schema::size(void) const
+  {
+      return _names.size();
+  }
+
+  // Function to get all column names
+  const std::vector<std::string> &Schema::names(void) const
+  {
+      return _names;
+  }
+
+  // Function to get a column name by its position
+  const std::string &Schema::name(unsigned int pos) const
+  {
+      return _names[pos];
+  }
+
+  // Function to get the position of a column by name
+  int Schema::index(const std::string &name) const
+  {
+      std::unordered_map<std::string, unsigned int>::const_iterator it = _index.find(name);
+
+      if (it == _index.end())
+          return -1;
+      return it->second;
+  }
+
+  /*
+  ** ARENA
+  */
+
+  static const size_t ARENA_BLOCK_SIZE = 64 * 1024;
+
+  // Constructor for the Arena class, blocks are allocated on first use
+  Arena::Arena(void)
+      : _used(0), _capacity(0) {}
+
+  // Function to copy bytes into the arena and return a stable view of them
+  std::string_view Arena::store(std::string_view value)
+  {
+      if (value.empty())
+          return std::string_view();
+
+      if (value.size() > _capacity - _used)
+      {
+          size_t size = std::max(value.size(), ARENA_BLOCK_SIZE);
+          _blocks.push_back(std::unique_ptr<char[]>(new char[size]));
+          _used = 0;
+          _capacity = size;
+      }
+      char *dest = _blocks.back().get() + _used;
+      std::memcpy(dest, value.data(), value.size());
+      _used += value.size();
+      return std::string_view(dest, value.size());
+  }
+
+  // Function to take over the blocks of another arena, views into them stay valid
+  void Arena::adopt(Arena &other)
+  {
+      for (auto it = other._blocks.begin(); it != other._blocks.end(); it++)
+          _blocks.insert(_blocks.end() - (_blocks.empty() ? 0 : 1), std::move(*it));
+      other._blocks.clear();
+      other._used = 0;
+      other._capacity = 0;
+  }
+
+  // Function to release everything stored so far
+  void Arena::clear(void)
+  {
+      _blocks.clear();
+      _used = 0;
+      _capacity = 0;
+  }
+
+  /*
+  ** MAPPEDFILE
+  */
+
+  // Constructor for the MappedFile class, maps the whole file read-only
+  MappedFile::MappedFile(const std::string &path)
+      : _data(nullptr), _size(0)
+  {
+#ifdef _WIN32
+      _mapping = nullptr;
+      HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+      if (file == INVALID_HANDLE_VALUE)
+          throw Error(std::string("Failed to open ").append(path));
+
+      LARGE_INTEGER size;
+      if (!GetFileSizeEx(file, &size))
+      {
+          CloseHandle(file);
+          throw Error(std::string("Failed to stat ").append(path));
+      }
+      _size = static_cast<size_t>(size.QuadPart);
+
+      if (_size > 0)
+      {
+          _mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+          if (_mapping != nullptr)
+              _data = static_cast<const char *>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+          if (_data == nullptr)
+          {
+              if (_mapping != nullptr)
+                  CloseHandle(_mapping);
+              CloseHandle(file);
+              throw Error(std::string("Failed to map ").append(path));
+          }
+      }
+      CloseHandle(file);
+#else
+      int fd = open(path.c_str(), O_RDONLY);
+      if (fd < 0)
+          throw Error(std::string("Failed to open ").append(path));
+
+      struct stat st;
+      if (fstat(fd, &st) != 0)
+      {
+          close(fd);
+          throw Error(std::string("Failed to stat ").append(path));
+      }
+      _size = static_cast<size_t>(st.st_size);
+
+      if (_size > 0)
+      {
+          void *addr = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+          if (addr == MAP_FAILED)
+          {
+              close(fd);
+              throw Error(std::string("Failed to map ").append(path));
+          }
+          madvise(addr, _size, MADV_SEQUENTIAL);
+          _data = static_cast<const char *>(addr);
+      }
+      close(fd);
+#endif
+  }
+
+  // Destructor for the MappedFile class
+  MappedFile::~MappedFile(void)
+  {
+#ifdef _WIN32
+      if (_data != nullptr)
+          UnmapViewOfFile(_data);
+      if (_mapping != nullptr)
+          CloseHandle(_mapping);
+#else
+      if (_data != nullptr)
+          munmap(const_cast<char *>(_data), _size);
+#endif
+  }
+
+  // Function to get the mapped bytes
+  std::string_view MappedFile::view(void) const
+  {
+      return std::string_view(_data, _size);
+  }
+
   /*
   ** ROW
   */
 
 
-  // Constructor for the Row class
-  Row::Row(const std::vector<std::string> &header)
-      : _header(header) {}
+  // Constructor for the Row class, a view of fields [first, first + size)
+  Row::Row(const Parser &parser, unsigned int first, unsigned int size)
+      : _parser(&parser), _first(first), _size(size) {}
 
   // Destructor for the Row class
   Row::~Row(void) {}
@@ -235,62 +1551,82 @@ namespace csv {
   // Function to get the size of the row
   unsigned int Row::size(void) const
   {
-    return _values.size();
-  }
-
-  // Function to add value to the row
-  void Row::push(const std::string &value)
-  {
-    _values.push_back(value);
+    return _size;
   }
 
   // Function to set a value in the row by key
   bool Row::set(const std::string &key, const std::string &value) 
   {
-    std::vector<std::string>::const_iterator it;
-    int pos = 0;
+    int pos = _parser->_schema->index(key);
 
-    for (it = _header.begin(); it != _header.end(); it++)
-    {
-        if (key == *it)
-        {
-          _values[pos] = value;
-          return true;
-        }
-        pos++;
-    }
-    return false;
+    if (pos < 0 || static_cast<unsigned int>(pos) >= _size)
+      return false;
+    _parser->_fields[_first + pos] = _parser->_arena.store(value);
+    _parser->logEdit(_first, pos);
+    return true;
   }
 
   // Overloaded operator to get a value by its position
   const std::string Row::operator[](unsigned int valuePosition) const
   {
-       if (valuePosition < _values.size())
-           return _values[valuePosition];
+       return std::string(view(valuePosition));
+  }
+
+  // Function to get a value by its position without copying it
+  std::string_view Row::view(unsigned int valuePosition) const
+  {
+       if (valuePosition < _size)
+           return _parser->_fields[_first + valuePosition];
        throw Error("can't return this value (doesn't exist)");
   }
 
+  // Function to get a value as an integer
+  std::errc Row::get(unsigned int valuePosition, long long &out) const
+  {
+      if (valuePosition >= _size)
+          return std::errc::invalid_argument;
+      return toInteger(_parser->_fields[_first + valuePosition], out);
+  }
+
+  // Function to get a value as a double
+  std::errc Row::get(unsigned int valuePosition, double &out) const
+  {
+      if (valuePosition >= _size)
+          return std::errc::invalid_argument;
+      return toDouble(_parser->_fields[_first + valuePosition], out);
+  }
+
+  // Function to get a currency value in cents
+  std::errc Row::getCents(unsigned int valuePosition, long long &out) const
+  {
+      if (valuePosition >= _size)
+          return std::errc::invalid_argument;
+      return toCents(_parser->_fields[_first + valuePosition], out);
+  }
+
+  // Function to get a date as days since 1970-01-01
+  std::errc Row::getDate(unsigned int valuePosition, int &out) const
+  {
+      if (valuePosition >= _size)
+          return std::errc::invalid_argument;
+      return toDate(_parser->_fields[_first + valuePosition], out);
+  }
+
   // Overloaded operator to get a value by key
   const std::string Row::operator[](const std::string &key) const
   {
-      std::vector<std::string>::const_iterator it;
-      int pos = 0;
+      int pos = _parser->_schema->index(key);
 
-      for (it = _header.begin(); it != _header.end(); it++)
-      {
-          if (key == *it)
-              return _values[pos];
-          pos++;
-      }
-      
+      if (pos >= 0 && static_cast<unsigned int>(pos) < _size)
+          return std::string(view(pos));
       throw Error("can't return this value (doesn't exist)");
   }
 
   // Overloaded operator to output a row to an ostream
   std::ostream &operator<<(std::ostream &os, const Row &row)
   {
-      for (unsigned int i = 0; i != row._values.size(); i++)
-          os << row._values[i] << " | ";
+      for (unsigned int i = 0; i != row._size; i++)
+          os << row.view(i) << " | ";
 
       return os;
   }
@@ -298,10 +1634,10 @@ namespace csv {
   // Overloaded operator to output a row to an ofstream
   std::ofstream &operator<<(std::ofstream &os, const Row &row)
   {
-    for (unsigned int i = 0; i != row._values.size(); i++)
+    for (unsigned int i = 0; i != row._size; i++)
     {
-        os << row._values[i];
-        if (i < row._values.size() - 1)
+        writeField(os, row.view(i));
+        if (i < row._size - 1)
           os << ",";
     }
     return os;
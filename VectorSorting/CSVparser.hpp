@@ -3,13 +3,47 @@
 
 # include <stdexcept>
 # include <string>
+# include <string_view>
 # include <vector>
-# include <list>
+# include <unordered_map>
+# include <memory>
 # include <sstream>
+# include <fstream>
+# include <ctime>
+# include <system_error>
+# include <cstdint>
+
+class ThreadPool;
 
 namespace csv
 {
     std::tm parseDate(const std::string& dateStr);
+    void writeField(std::ostream &, std::string_view, char sep = ',');
+    void writeField(std::string &, std::string_view, char sep = ',');     // appends
+    uint64_t hashBytes(std::string_view);     // 64-bit hash, eight bytes per step
+
+    // Typed conversions of a single value. Surrounding blanks are ignored; they
+    // never throw or allocate and return std::errc() on success,
+    // invalid_argument if the value doesn't parse and result_out_of_range if it
+    // doesn't fit.
+    std::errc toInteger(std::string_view, long long &);
+    std::errc toDouble(std::string_view, double &);
+    std::errc toCents(std::string_view, long long &);   // "$3,000.50 " -> 300050
+    std::errc toDate(std::string_view, int &);          // "MM/DD/YYYY" -> days since 1970-01-01
+    std::string formatDate(int);                        // days since 1970-01-01 -> "M/D/YYYY"
+    void civilDate(int days, int &year, int &month, int &day);
+
+    // Field tokenizer implementations; the best one the CPU supports is used
+    // unless another is forced with setTokenizer
+    enum Tokenizer {
+        eSCALAR = 0,
+        eSSE2 = 1,      // x86-64 only
+        eAVX2 = 2       // x86-64 with AVX2 only
+    };
+
+    Tokenizer bestTokenizer(void);
+    Tokenizer getTokenizer(void);
+    bool setTokenizer(Tokenizer);
 
     class Error : public std::runtime_error
     {
@@ -21,31 +55,105 @@ namespace csv
         }
     };
 
+    // Read-only memory mapping of a whole file, released on destruction
+    class MappedFile
+    {
+      public:
+        MappedFile(const std::string &);
+        ~MappedFile(void);
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+      public:
+        std::string_view view(void) const;
+
+      private:
+        const char *_data;
+        size_t _size;
+    #ifdef _WIN32
+        void *_mapping;
+    #endif
+    };
+
+    // Column names shared by every row of a parser, with O(1) name lookup
+    class Schema
+    {
+      public:
+        Schema(const std::vector<std::string> &);
+
+      public:
+        unsigned int size(void) const;
+        const std::vector<std::string> &names(void) const;
+        const std::string &name(unsigned int) const;
+        int index(const std::string &) const;   // -1 when the column doesn't exist
+
+      private:
+        std::vector<std::string> _names;
+        std::unordered_map<std::string, unsigned int> _index;
+    };
+
+    // Position of one record's fields in a flat field array
+    struct RowSpan
+    {
+        unsigned int first;
+        unsigned int size;
+    };
+
+    // Append-only byte storage for values that don't come from the input
+    // buffer; views into it stay valid until the arena is destroyed
+    class Arena
+    {
+      public:
+        Arena(void);
+
+      public:
+        std::string_view store(std::string_view);
+        void adopt(Arena &);
+        void clear(void);
+
+      private:
+        std::vector<std::unique_ptr<char[]>> _blocks;
+        size_t _used;
+        size_t _capacity;
+    };
+
+    class Parser;
+
+    // Lightweight view of one row stored in a Parser
     class Row
     {
     	public:
-    	    Row(const std::vector<std::string> &);
+    	    Row(const Parser &, unsigned int first, unsigned int size);
     	    ~Row(void);
 
     	public:
             unsigned int size(void) const;
-            void push(const std::string &);
             bool set(const std::string &, const std::string &); 
+            std::string_view view(unsigned int) const;
+
+            // typed accessors, see csv::toInteger and friends; a missing
+            // position gives invalid_argument
+            std::errc get(unsigned int, long long &) const;
+            std::errc get(unsigned int, double &) const;
+            std::errc getCents(unsigned int, long long &) const;
+            std::errc getDate(unsigned int, int &) const;
 
     	private:
-    		const std::vector<std::string> _header;
-    		std::vector<std::string> _values;
+    		const Parser *_parser;
+    		unsigned int _first;    // index of the row's first field in the parser
+    		unsigned int _size;
 
         public:
 
             template<typename T>
             const T getValue(unsigned int pos) const
             {
-                if (pos < _values.size())
+                if (pos < _size)
                 {
                     T res;
                     std::stringstream ss;
-                    ss << _values[pos];
+                    ss << view(pos);
                     ss >> res;
                     return res;
                 }
@@ -59,21 +167,34 @@ namespace csv
 
     enum DataType {
         eFILE = 0,
-        ePURE = 1
+        ePURE = 1,
+        eMMAP = 2,  // file is memory-mapped, fields are views into the mapping
+        eWRITE_BACK = 3 // eFILE whose changes are written back as they are made
     };
 
+    // eWRITE_BACK: encoded rows and log records are buffered up to this many
+    // bytes before they are written, and sync() compacts the file once its
+    // log grows past the compact limit
+    static const size_t WRITE_BACK_BUFFER = 1 << 20;
+    static const size_t WRITE_BACK_COMPACT_LIMIT = 4 << 20;
+
     class Parser
     {
 
     public:
-        Parser(const std::string &, const DataType &type = eFILE, char sep = ',');
+        // threads > 1 (or 0 for one per hardware thread) parses the content in parallel
+        Parser(const std::string &, const DataType &type = eFILE, char sep = ',', unsigned int threads = 1);
         ~Parser(void);
 
+        Parser(const Parser &) = delete;
+        Parser &operator=(const Parser &) = delete;
+
     public:
-        Row &getRow(unsigned int row) const;
+        Row getRow(unsigned int row) const;
         unsigned int rowCount(void) const;
         unsigned int columnCount(void) const;
         std::vector<std::string> getHeader(void) const;
+        const Schema &getSchema(void) const;
         const std::string getHeaderElement(unsigned int pos) const;
         const std::string &getFileName(void) const;
 
@@ -82,21 +203,103 @@ namespace csv
         bool addRow(unsigned int pos, const std::vector<std::string> &);
         void sync(void) const;
 
+        // eWRITE_BACK: rows added at the end are appended to the file, while
+        // deletions, inserts elsewhere and Row::set edits are recorded in a
+        // side log <file>.log that is replayed when the file is opened again.
+        // flush() writes out what is buffered, compact() rewrites the file
+        // from the rows in memory and drops the log.
+        void flush(void) const;
+        void compact(void) const;
+        void setCompactLimit(size_t);
+        std::string getLogName(void) const;
+
     protected:
-    	void parseHeader(void);
-    	void parseContent(void);
+    	bool parseHeader(std::string_view &);
+    	void parseContent(std::string_view);
+    	void insertRow(unsigned int pos, const std::string_view *, size_t);
+    	void replayLog(void);
+    	void logInsert(unsigned int pos) const;
+    	void logDelete(unsigned int pos) const;
+    	void logEdit(unsigned int first, unsigned int column) const;
+    	void written(void) const;
 
     private:
         std::string _file;
         const DataType _type;
         const char _sep;
-        std::vector<std::string> _originalFile;
-        std::vector<std::string> _header;
-        std::vector<Row *> _content;
+        const unsigned int _threads;
+        std::string _data;                  // raw bytes for eFILE / ePURE
+        std::unique_ptr<MappedFile> _map;   // raw bytes for eMMAP
+        std::shared_ptr<const Schema> _schema;
 
+        // Row storage: every field of every row is a view in one flat array,
+        // pointing into _data / _map or into _arena for added and edited values.
+        // Rows handed out by the const accessors can still be edited through
+        // Row::set, hence mutable.
+        mutable std::vector<std::string_view> _fields;
+        std::vector<RowSpan> _content;
+        mutable Arena _arena;
+
+        // eWRITE_BACK state, changed by Row::set through a const parser too
+        size_t _compactLimit;
+        mutable std::string _appended;      // encoded rows not yet appended to the file
+        mutable std::string _log;           // log records not yet written
+        mutable uint64_t _logSize;          // bytes in the log file, 0 while there is none
+        mutable bool _newline;              // the file ends with a line break
+
+        // Row position by first field, for logging Row::set edits; rebuilt
+        // on the next edit once rows were deleted or inserted before the end
+        mutable std::unordered_map<unsigned int, unsigned int> _rowByField;
+        mutable bool _rowByFieldStale;
+
+        friend class Row;
 
     public:
-        Row &operator[](unsigned int row) const;
+        Row operator[](unsigned int row) const;
+    };
+
+    // Streaming reader: reads a file in fixed-size chunks and hands out one
+    // record at a time, so memory stays bounded by the chunk size (or by the
+    // longest record, if that is larger)
+    class Reader
+    {
+
+    public:
+        // threads > 1 (or 0 for one per hardware thread) parses each chunk in parallel
+        Reader(const std::string &, char sep = ',', size_t chunkSize = 1024 * 1024, unsigned int threads = 1);
+        ~Reader(void);
+
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+
+    public:
+        const Schema &getSchema(void) const;
+        const std::string &getFileName(void) const;
+
+        // Fetch the next well-formed record; the views stay valid until the
+        // following call. Returns false once the file is exhausted.
+        bool next(std::vector<std::string_view> &);
+
+    protected:
+        bool read(void);
+        bool fill(void);
+
+    private:
+        std::string _file;
+        std::ifstream _in;
+        const char _sep;
+        std::vector<char> _buffer;
+        size_t _begin;      // first unparsed byte in _buffer
+        size_t _end;        // one past the last byte read into _buffer
+        bool _eof;
+        std::shared_ptr<const Schema> _schema;
+
+        // records parsed from the current chunk, served by next()
+        std::vector<std::string_view> _fields;
+        std::vector<RowSpan> _rows;
+        Arena _arena;       // unescaped values of the current chunk
+        size_t _cursor;
+        std::unique_ptr<ThreadPool> _pool;
     };
 }
 
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <numeric>
+#include "Dictionary.hpp"
+
+// Constructor for the Dictionary class, code 0 is the empty value and
+// stays first in string order
+Dictionary::Dictionary(void)
+  : _sorted(true)
+{
+    encode(std::string_view());
+}
+
+// Function to get the code of a value, adding it on first sight
+uint32_t Dictionary::encode(std::string_view value)
+{
+    std::unordered_map<std::string_view, uint32_t>::const_iterator it = _codes.find(value);
+
+    if (it != _codes.end())
+        return it->second;
+
+    std::string_view stored = _bytes.store(value);
+    uint32_t code = static_cast<uint32_t>(_values.size());
+    if (!_values.empty() && _values.back() > stored)
+        _sorted = false;
+    _values.push_back(stored);
+    _codes.emplace(stored, code);
+    return code;
+}
+
+// Function to get the code of a value that is already in the dictionary
+bool Dictionary::find(std::string_view value, uint32_t &code) const
+{
+    std::unordered_map<std::string_view, uint32_t>::const_iterator it = _codes.find(value);
+
+    if (it == _codes.end())
+        return false;
+    code = it->second;
+    return true;
+}
+
+// Function to get the value of a code
+std::string_view Dictionary::decode(uint32_t code) const
+{
+    return _values[code];
+}
+
+// Function to get the number of distinct values
+uint32_t Dictionary::size(void) const
+{
+    return static_cast<uint32_t>(_values.size());
+}
+
+// Function to tell whether codes currently follow string order
+bool Dictionary::sorted(void) const
+{
+    return _sorted;
+}
+
+// Function to renumber the codes in string order
+std::vector<uint32_t> Dictionary::sort(void)
+{
+    std::vector<uint32_t> order(_values.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return _values[a] < _values[b]; });
+
+    std::vector<uint32_t> remap(_values.size());
+    std::vector<std::string_view> values(_values.size());
+    for (uint32_t code = 0; code < order.size(); code++)
+    {
+        remap[order[code]] = code;
+        values[code] = _values[order[code]];
+        _codes[values[code]] = code;
+    }
+    _values.swap(values);
+    _sorted = true;
+    return remap;
+}
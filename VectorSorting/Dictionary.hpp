@@ -0,0 +1,40 @@
+#ifndef     _DICTIONARY_HPP_
+# define    _DICTIONARY_HPP_
+
+# include <cstdint>
+# include <string_view>
+# include <unordered_map>
+# include <vector>
+# include "CSVparser.hpp"
+
+// Dictionary encoding for low-cardinality columns: each distinct value gets a
+// small integer code. Once sort() has run, codes follow string order, so
+// comparing two codes orders them exactly like comparing their strings.
+// Code 0 is always the empty value.
+class Dictionary
+{
+  public:
+    Dictionary(void);
+
+    Dictionary(const Dictionary &) = delete;
+    Dictionary &operator=(const Dictionary &) = delete;
+
+  public:
+    uint32_t encode(std::string_view);              // adds the value if it is new
+    bool find(std::string_view, uint32_t &) const;  // lookup only
+    std::string_view decode(uint32_t) const;
+    uint32_t size(void) const;
+
+    // Renumber the codes in string order. Returns the old code -> new code
+    // map that every stored code has to be passed through.
+    bool sorted(void) const;
+    std::vector<uint32_t> sort(void);
+
+  private:
+    csv::Arena _bytes;
+    std::vector<std::string_view> _values;
+    std::unordered_map<std::string_view, uint32_t> _codes;
+    bool _sorted;
+};
+
+#endif /*!_DICTIONARY_HPP_*/
@@ -0,0 +1,365 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "ExternalSort.hpp"
+#include "CSVparser.hpp"
+#include "PdqSort.hpp"
+
+using namespace std;
+
+// Stream buffer of each run file and of the output
+static const size_t RUN_BUFFER_SIZE = 256 * 1024;
+
+// One record of a run: its sort key and its bytes as a CSV line. Run files
+// hold the same fields, with the two views stored inline after the numbers.
+struct RunRecord {
+    uint64_t key;           // numeric key, 0 when sorting on a text column
+    uint64_t index;         // position in the input, breaks ties
+    string_view text;       // text key, empty when sorting on a numeric column
+    string_view line;       // the record without its line break
+};
+
+// Order of records in the output
+struct RecordOrder {
+    bool descending;
+
+    bool operator()(const RunRecord& a, const RunRecord& b) const {
+        // numeric keys are directed up front, see directedKey
+        if (a.key != b.key) {
+            return a.key < b.key;
+        }
+        int order = a.text.compare(b.text);
+        if (order != 0) {
+            return descending ? order > 0 : order < 0;
+        }
+        return a.index < b.index;
+    }
+};
+
+// Temporary run files, removed when the sort finishes or fails
+struct RunFiles {
+    vector<string> paths;
+
+    ~RunFiles() {
+        for (const string& path : paths) {
+            remove(path.c_str());
+        }
+    }
+};
+
+// Sequential reader of one run file
+class RunReader {
+  public:
+    RunReader(const string& path)
+        : _buffer(new char[RUN_BUFFER_SIZE]) {
+        _in.rdbuf()->pubsetbuf(_buffer.get(), RUN_BUFFER_SIZE);
+        _in.open(path, ios::in | ios::binary);
+        if (!_in.is_open()) {
+            throw csv::Error(string("Failed to open ").append(path));
+        }
+    }
+
+    // Load the next record into current(), false at the end of the run
+    bool next() {
+        uint32_t sizes[2];
+
+        if (!_in.read(reinterpret_cast<char*>(&_record.key), sizeof(_record.key))) {
+            return false;
+        }
+        _in.read(reinterpret_cast<char*>(&_record.index), sizeof(_record.index));
+        _in.read(reinterpret_cast<char*>(sizes), sizeof(sizes));
+        _text.resize(sizes[0]);
+        _line.resize(sizes[1]);
+        _in.read(&_text[0], sizes[0]);
+        _in.read(&_line[0], sizes[1]);
+        if (!_in) {
+            throw csv::Error("Truncated sort run");
+        }
+        _record.text = _text;
+        _record.line = _line;
+        return true;
+    }
+
+    const RunRecord& current() const {
+        return _record;
+    }
+
+  private:
+    unique_ptr<char[]> _buffer;
+    ifstream _in;
+    string _text;
+    string _line;
+    RunRecord _record;
+};
+
+// Tournament tree over the current records of k runs. Every inner node
+// keeps the loser of the match played there and the overall winner sits on
+// top, so replacing the winner replays one leaf-to-root path: log2(k)
+// comparisons per record instead of k.
+class LoserTree {
+  public:
+    LoserTree(vector<unique_ptr<RunReader>>& runs, RecordOrder order)
+        : _runs(runs), _order(order), _live(runs.size()), _nodes(runs.size()) {
+        size_t k = runs.size();
+        vector<size_t> winners(2 * k);
+
+        for (size_t i = 0; i < k; ++i) {
+            _live[i] = runs[i]->next();
+            winners[k + i] = i;
+        }
+        for (size_t node = k - 1; node >= 1; --node) {
+            size_t a = winners[2 * node];
+            size_t b = winners[2 * node + 1];
+            if (beats(b, a)) {
+                swap(a, b);
+            }
+            winners[node] = a;
+            _nodes[node] = b;
+        }
+        _nodes[0] = k == 1 ? 0 : winners[1];
+    }
+
+    // The smallest current record, false once every run is exhausted
+    bool top(const RunRecord*& record) const {
+        if (!_live[_nodes[0]]) {
+            return false;
+        }
+        record = &_runs[_nodes[0]]->current();
+        return true;
+    }
+
+    // Advance the run that produced the top record
+    void pop() {
+        size_t k = _runs.size();
+        size_t winner = _nodes[0];
+
+        _live[winner] = _runs[winner]->next();
+        for (size_t node = (winner + k) / 2; node >= 1; node /= 2) {
+            if (beats(_nodes[node], winner)) {
+                swap(_nodes[node], winner);
+            }
+        }
+        _nodes[0] = winner;
+    }
+
+  private:
+    // exhausted runs lose every match
+    bool beats(size_t a, size_t b) const {
+        if (!_live[a] || !_live[b]) {
+            return _live[a] && !_live[b];
+        }
+        return _order(_runs[a]->current(), _runs[b]->current());
+    }
+
+    vector<unique_ptr<RunReader>>& _runs;
+    RecordOrder _order;
+    vector<bool> _live;
+    vector<size_t> _nodes;      // [0] winner, [1..k) losers
+};
+
+/**
+ * Append one record to a run file
+ */
+static void writeRunRecord(ostream& out, const RunRecord& record) {
+    uint32_t sizes[2] = { static_cast<uint32_t>(record.text.size()),
+                          static_cast<uint32_t>(record.line.size()) };
+
+    out.write(reinterpret_cast<const char*>(&record.key), sizeof(record.key));
+    out.write(reinterpret_cast<const char*>(&record.index), sizeof(record.index));
+    out.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+    out.write(record.text.data(), record.text.size());
+    out.write(record.line.data(), record.line.size());
+}
+
+/**
+ * Open a file for writing with a large stream buffer
+ *
+ * @param out the stream to open
+ * @param buffer receives the buffer, which must outlive the stream
+ */
+static void openOutput(ofstream& out, const string& path, unique_ptr<char[]>& buffer, bool binary) {
+    buffer.reset(new char[RUN_BUFFER_SIZE]);
+    out.rdbuf()->pubsetbuf(buffer.get(), RUN_BUFFER_SIZE);
+    out.open(path, binary ? ios::out | ios::trunc | ios::binary : ios::out | ios::trunc);
+    if (!out.is_open()) {
+        throw csv::Error(string("Failed to create ").append(path));
+    }
+}
+
+/**
+ * Write the header line of the sorted CSV file
+ */
+static void writeHeader(ostream& out, const csv::Schema& schema) {
+    string line;
+    for (unsigned int i = 0; i < schema.size(); ++i) {
+        if (i > 0) {
+            line += ',';
+        }
+        csv::writeField(line, schema.name(i));
+    }
+    out << line << '\n';
+}
+
+/**
+ * Sort the records in memory and write them to a new run file
+ */
+static void spillRun(vector<RunRecord>& records, RecordOrder order, RunFiles& runs, const string& output) {
+    ofstream out;
+    unique_ptr<char[]> buffer;
+    string path = output + ".run" + to_string(runs.paths.size());
+
+    pdq::pdqsort(records.begin(), records.end(), order);
+    runs.paths.push_back(path);
+    openOutput(out, path, buffer, true);
+    for (const RunRecord& record : records) {
+        writeRunRecord(out, record);
+    }
+    if (!out.flush()) {
+        throw csv::Error(string("Failed to write ").append(path));
+    }
+}
+
+/**
+ * Merge run files into one sorted stream, written either as another run
+ * or as the lines of the output CSV
+ */
+static void mergeRuns(const vector<string>& paths, RecordOrder order, ostream& out, bool asRun) {
+    vector<unique_ptr<RunReader>> readers;
+    for (const string& path : paths) {
+        readers.emplace_back(new RunReader(path));
+    }
+
+    LoserTree tree(readers, order);
+    const RunRecord* record;
+    while (tree.top(record)) {
+        if (asRun) {
+            writeRunRecord(out, *record);
+        } else {
+            out.write(record->line.data(), record->line.size());
+            out.put('\n');
+        }
+        tree.pop();
+    }
+}
+
+/**
+ * Sort a bid CSV file by one column into another CSV file, holding at
+ * most about memoryLimit bytes of records in memory
+ *
+ * @param input the CSV file to sort
+ * @param output the sorted CSV file to write
+ * @param key column to order by
+ * @param descending true for largest first
+ * @param memoryLimit bytes of records sorted in memory per run
+ */
+void externalSort(const string& input, const string& output, SortKey key, bool descending,
+                  size_t memoryLimit) {
+    csv::Reader file(input);
+    BidColumns columns = resolveColumns(file.getSchema());
+    RecordOrder order = { descending };
+
+    // text columns compare raw fields, department and fund codes only exist
+    // for loaded tables
+    int textColumn = -1;
+    if (key == eTITLE) {
+        textColumn = columns.title;
+    } else if (key == eDEPARTMENT) {
+        textColumn = columns.department;
+    } else if (key == eFUND) {
+        textColumn = columns.fund;
+    }
+
+    RunFiles runs;
+    vector<RunRecord> records;
+    csv::Arena arena;
+    size_t used = 0;
+    uint64_t index = 0;
+    vector<string_view> row;
+    string line;
+
+    while (file.next(row)) {
+        // a short record has no field for some column, loading skips it too
+        if (row.size() < columns.fields) {
+            continue;
+        }
+
+        RunRecord record;
+
+        line.clear();
+        for (size_t i = 0; i < row.size(); ++i) {
+            if (i > 0) {
+                line += ',';
+            }
+            csv::writeField(line, row[i]);
+        }
+        record.index = index++;
+        record.key = 0;
+        if (textColumn >= 0) {
+            record.text = arena.store(row[textColumn]);
+        } else {
+            record.key = directedKey(parseBidNumbers(row, columns), key, descending);
+        }
+        record.line = arena.store(line);
+        records.push_back(record);
+
+        used += sizeof(RunRecord) + record.text.size() + record.line.size();
+        if (used >= memoryLimit) {
+            spillRun(records, order, runs, output);
+            records.clear();
+            arena.clear();
+            used = 0;
+        }
+    }
+
+    ofstream out;
+    unique_ptr<char[]> buffer;
+
+    // everything fit in memory, no runs needed
+    if (runs.paths.empty()) {
+        pdq::pdqsort(records.begin(), records.end(), order);
+        openOutput(out, output, buffer, false);
+        writeHeader(out, file.getSchema());
+        for (const RunRecord& record : records) {
+            out.write(record.line.data(), record.line.size());
+            out.put('\n');
+        }
+    } else {
+        if (!records.empty()) {
+            spillRun(records, order, runs, output);
+            records.clear();
+            arena.clear();
+        }
+
+        // merge groups of runs until one pass can merge the rest
+        size_t first = 0;
+        while (runs.paths.size() - first > EXTERNAL_SORT_FAN_IN) {
+            vector<string> group(runs.paths.begin() + first, runs.paths.begin() + first + EXTERNAL_SORT_FAN_IN);
+            string path = output + ".run" + to_string(runs.paths.size());
+            ofstream merged;
+            unique_ptr<char[]> mergedBuffer;
+
+            runs.paths.push_back(path);
+            openOutput(merged, path, mergedBuffer, true);
+            mergeRuns(group, order, merged, true);
+            if (!merged.flush()) {
+                throw csv::Error(string("Failed to write ").append(path));
+            }
+            merged.close();
+            for (const string& done : group) {
+                remove(done.c_str());
+            }
+            first += EXTERNAL_SORT_FAN_IN;
+        }
+
+        openOutput(out, output, buffer, false);
+        writeHeader(out, file.getSchema());
+        mergeRuns(vector<string>(runs.paths.begin() + first, runs.paths.end()), order, out, false);
+    }
+
+    if (!out.flush()) {
+        throw csv::Error(string("Failed to write ").append(output));
+    }
+}
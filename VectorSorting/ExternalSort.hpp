@@ -0,0 +1,21 @@
+#ifndef     _EXTERNALSORT_HPP_
+# define    _EXTERNALSORT_HPP_
+
+# include <cstddef>
+# include <string>
+# include "BidSort.hpp"
+
+// Records held in memory at once by externalSort, line bytes included
+static const size_t EXTERNAL_SORT_MEMORY = 64 * 1024 * 1024;
+
+// Runs merged at once; more runs are merged in several passes
+static const size_t EXTERNAL_SORT_FAN_IN = 64;
+
+// Sort a bid CSV file by one column into another CSV file without loading
+// it: sorted runs of at most memoryLimit bytes are spilled next to the
+// output and merged with a loser tree. Every column of the input is kept,
+// written the way Parser::sync writes rows. Ties keep input order.
+void externalSort(const std::string& input, const std::string& output, SortKey key,
+                  bool descending = false, size_t memoryLimit = EXTERNAL_SORT_MEMORY);
+
+#endif /*!_EXTERNALSORT_HPP_*/
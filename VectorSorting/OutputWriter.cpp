@@ -0,0 +1,96 @@
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include "OutputWriter.hpp"
+
+#ifdef _WIN32
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+
+// Constructor for the OutputWriter class
+OutputWriter::OutputWriter(int fd, size_t capacity)
+  : _fd(fd), _buffer(capacity < 64 ? 64 : capacity), _size(0)
+{
+    std::cout.flush();
+}
+
+// Destructor for the OutputWriter class, writes out what is left
+OutputWriter::~OutputWriter(void)
+{
+    flush();
+}
+
+// Function to append text, text longer than the buffer goes out directly
+OutputWriter &OutputWriter::operator<<(std::string_view text)
+{
+    if (text.size() > _buffer.size() - _size)
+    {
+        flush();
+        if (text.size() >= _buffer.size())
+        {
+            writeAll(text.data(), text.size());
+            return *this;
+        }
+    }
+    // an empty view may hold a null pointer, which memcpy must not get
+    if (!text.empty())
+    {
+        std::memcpy(_buffer.data() + _size, text.data(), text.size());
+        _size += text.size();
+    }
+    return *this;
+}
+
+// Function to append one character
+OutputWriter &OutputWriter::operator<<(char c)
+{
+    reserve(1);
+    _buffer[_size++] = c;
+    return *this;
+}
+
+// Function to append a number the way std::ostream prints it by default
+OutputWriter &OutputWriter::operator<<(double value)
+{
+    // "-1.23457e-308" and the like, with room to spare
+    reserve(32);
+    _size = std::to_chars(_buffer.data() + _size, _buffer.data() + _buffer.size(), value,
+                          std::chars_format::general, 6).ptr - _buffer.data();
+    return *this;
+}
+
+// Function to write the buffer out
+void OutputWriter::flush(void)
+{
+    writeAll(_buffer.data(), _size);
+    _size = 0;
+}
+
+// Function to make room for count more bytes
+void OutputWriter::reserve(size_t count)
+{
+    if (_buffer.size() - _size < count)
+        flush();
+}
+
+// Function to write bytes to the descriptor; write() may take less than
+// asked, so loop until all of them are gone or the descriptor fails
+void OutputWriter::writeAll(const char *data, size_t size)
+{
+    size_t done = 0;
+    while (done < size)
+    {
+#ifdef _WIN32
+        int written = _write(_fd, data + done, static_cast<unsigned int>(size - done));
+#else
+        ssize_t written = write(_fd, data + done, size - done);
+#endif
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            break;
+        done += static_cast<size_t>(written);
+    }
+}
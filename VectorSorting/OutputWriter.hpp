@@ -0,0 +1,53 @@
+#ifndef     _OUTPUTWRITER_HPP_
+# define    _OUTPUTWRITER_HPP_
+
+# include <charconv>
+# include <cstddef>
+# include <string_view>
+# include <type_traits>
+# include <vector>
+
+// Default size of the OutputWriter buffer
+static const size_t OUTPUT_BUFFER_SIZE = 1 << 16;
+
+// Buffered writer to a file descriptor, stdout by default. Text and numbers
+// are formatted straight into one reusable buffer, which goes out in a
+// single write() whenever it fills up, instead of a flush per line as with
+// std::endl. std::cout is flushed on construction so earlier prompts stay
+// in order.
+class OutputWriter
+{
+  public:
+    explicit OutputWriter(int fd = 1, size_t capacity = OUTPUT_BUFFER_SIZE);
+    ~OutputWriter(void);
+
+    OutputWriter(const OutputWriter &) = delete;
+    OutputWriter &operator=(const OutputWriter &) = delete;
+
+  public:
+    OutputWriter &operator<<(std::string_view);
+    OutputWriter &operator<<(char);
+    OutputWriter &operator<<(double);       // like std::ostream: 6 significant digits
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputWriter &>::type operator<<(T value)
+    {
+        // 20 digits and a sign fit any 64 bit integer
+        reserve(21);
+        _size = std::to_chars(_buffer.data() + _size, _buffer.data() + _buffer.size(), value).ptr - _buffer.data();
+        return *this;
+    }
+
+    void flush(void);
+
+  protected:
+    void reserve(size_t);
+    void writeAll(const char *, size_t);
+
+  private:
+    int _fd;
+    std::vector<char> _buffer;
+    size_t _size;
+};
+
+#endif /*!_OUTPUTWRITER_HPP_*/
@@ -0,0 +1,136 @@
+#ifndef     _PARALLELSORT_HPP_
+# define    _PARALLELSORT_HPP_
+
+# include <algorithm>
+# include <cstddef>
+# include <vector>
+# include "PdqSort.hpp"
+# include "ThreadPool.hpp"
+
+// Below this many elements parallelSort sorts on the calling thread only
+static const size_t PARALLEL_SORT_CUTOFF = 1 << 16;
+
+namespace pdq
+{
+namespace detail
+{
+
+// Merge path split: how many elements of a come first in the first d outputs
+// of merging a and b. Ties take from a, so merges stay stable.
+template <class Iter, class Compare>
+inline size_t mergeSplit(Iter a, size_t na, Iter b, size_t nb, size_t d, Compare comp)
+{
+    size_t lo = d > nb ? d - nb : 0;
+    size_t hi = std::min(d, na);
+
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (comp(b[d - mid - 1], a[mid]))
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+// One independent slice of a merge round
+struct MergePiece
+{
+    size_t a, aEnd;
+    size_t b, bEnd;
+    size_t out;
+};
+
+} // namespace detail
+
+// Parallel merge sort on a thread pool. The vector is cut into several runs
+// per thread that are sorted with pdqsort, then pairs of runs are merged in
+// rounds. Each merge is split along its merge path so late rounds with only
+// a couple of runs still keep every thread busy. Idle threads pull the next
+// piece from the pool, so uneven pieces even out. Uses one buffer of n
+// elements. Set Branchless for cheap comparisons, as with pdqsortBranchless.
+template <bool Branchless = false, class T, class Compare>
+void parallelSort(std::vector<T> &values, Compare comp, ThreadPool &pool,
+                  size_t cutoff = PARALLEL_SORT_CUTOFF)
+{
+    size_t n = values.size();
+    size_t threads = pool.size();
+
+    if (n < cutoff || n < 2 || threads < 2)
+    {
+        if (Branchless)
+            pdqsortBranchless(values.begin(), values.end(), comp);
+        else
+            pdqsort(values.begin(), values.end(), comp);
+        return;
+    }
+
+    size_t runs = std::min(threads * 4, n);
+    std::vector<size_t> bounds(runs + 1);
+    for (size_t k = 0; k <= runs; k++)
+        bounds[k] = n * k / runs;
+
+    pool.run(runs, [&values, &bounds, &comp](size_t k) {
+        if (Branchless)
+            pdqsortBranchless(values.begin() + bounds[k], values.begin() + bounds[k + 1], comp);
+        else
+            pdqsort(values.begin() + bounds[k], values.begin() + bounds[k + 1], comp);
+    });
+
+    std::vector<T> buffer(n);
+    std::vector<T> *from = &values;
+    std::vector<T> *to = &buffer;
+    std::vector<detail::MergePiece> pieces;
+
+    while (bounds.size() > 2)
+    {
+        size_t count = bounds.size() - 1;
+        size_t pairs = count / 2;
+        size_t parts = std::max<size_t>(1, threads * 2 / pairs);
+        std::vector<size_t> merged;
+
+        pieces.clear();
+        for (size_t p = 0; p < pairs; p++)
+        {
+            size_t lo = bounds[2 * p], mid = bounds[2 * p + 1], hi = bounds[2 * p + 2];
+            size_t na = mid - lo, nb = hi - mid;
+            size_t i0 = 0;
+
+            for (size_t part = 1; part <= parts; part++)
+            {
+                size_t d0 = (na + nb) * (part - 1) / parts;
+                size_t d1 = (na + nb) * part / parts;
+                size_t i1 = part == parts ? na
+                          : detail::mergeSplit(from->begin() + lo, na, from->begin() + mid, nb, d1, comp);
+                pieces.push_back({ lo + i0, lo + i1, mid + (d0 - i0), mid + (d1 - i1), lo + d0 });
+                i0 = i1;
+            }
+            merged.push_back(lo);
+        }
+        // an odd run out is copied over unchanged
+        if (count % 2)
+        {
+            pieces.push_back({ bounds[count - 1], bounds[count], bounds[count], bounds[count], bounds[count - 1] });
+            merged.push_back(bounds[count - 1]);
+        }
+        merged.push_back(n);
+
+        pool.run(pieces.size(), [from, to, &pieces, &comp](size_t k) {
+            const detail::MergePiece &piece = pieces[k];
+            std::merge(from->begin() + piece.a, from->begin() + piece.aEnd,
+                       from->begin() + piece.b, from->begin() + piece.bEnd,
+                       to->begin() + piece.out, comp);
+        });
+
+        bounds.swap(merged);
+        std::swap(from, to);
+    }
+
+    if (from != &values)
+        values.swap(buffer);
+}
+
+} // namespace pdq
+
+#endif /*!_PARALLELSORT_HPP_*/
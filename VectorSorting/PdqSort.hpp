@@ -0,0 +1,540 @@
+/*
+    Altered from pdqsort.h - Pattern-defeating quicksort
+    (https://github.com/orlp/pdqsort). This is not the original software:
+    it was moved into the pdq namespace with renamed identifiers, and
+    pdqsortByKey was added.
+
+    Copyright (c) 2021 Orson Peters
+
+    This software is provided 'as-is', without any express or implied warranty. In no event will the
+    authors be held liable for any damages arising from the use of this software.
+
+    Permission is granted to anyone to use this software for any purpose, including commercial
+    applications, and to alter it and redistribute it freely, subject to the following restrictions:
+
+    1. The origin of this software must not be misrepresented; you must not claim that you wrote the
+       original software. If you use this software in a product, an acknowledgment in the product
+       documentation would be appreciated but is not required.
+
+    2. Altered source versions must be plainly marked as such, and must not be misrepresented as
+       being the original software.
+
+    3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef     _PDQSORT_HPP_
+# define    _PDQSORT_HPP_
+
+# include <algorithm>
+# include <cstddef>
+# include <cstdint>
+# include <functional>
+# include <iterator>
+# include <type_traits>
+# include <utility>
+
+// Pattern-defeating quicksort (after Orson Peters' pdqsort): median-of-3 or
+// ninther pivots, insertion sort for small partitions, a heapsort fallback once
+// too many partitions came out unbalanced, and detection of already sorted
+// runs. Worst case O(n log n), recursion depth O(log n).
+//
+// pdqsortBranchless partitions in blocks, recording comparison results as
+// offsets instead of branching on them. It wins for cheap comparisons on
+// trivially copyable values (integers, row numbers, key/row pairs) and loses
+// for expensive ones such as string compares.
+namespace pdq
+{
+namespace detail
+{
+
+enum
+{
+    INSERTION_SORT_THRESHOLD = 24,      // partitions below this size get insertion sort
+    NINTHER_THRESHOLD = 128,            // partitions above this size get a ninther pivot
+    PARTIAL_INSERTION_SORT_LIMIT = 8,   // moves allowed before giving up on a nearly sorted run
+    BLOCK_SIZE = 64,                    // elements per block in the branchless partition
+    CACHELINE_SIZE = 64
+};
+
+template <class T>
+inline int log2(T n)
+{
+    int log = 0;
+    while (n >>= 1)
+        ++log;
+    return log;
+}
+
+// Sorts [begin, end) using insertion sort
+template <class Iter, class Compare>
+inline void insertionSort(Iter begin, Iter end, Compare comp)
+{
+    typedef typename std::iterator_traits<Iter>::value_type T;
+
+    if (begin == end)
+        return;
+    for (Iter cur = begin + 1; cur != end; ++cur)
+    {
+        Iter sift = cur;
+        Iter sift1 = cur - 1;
+        if (comp(*sift, *sift1))
+        {
+            T tmp = std::move(*sift);
+            do
+                *sift-- = std::move(*sift1);
+            while (sift != begin && comp(tmp, *--sift1));
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// Sorts [begin, end) using insertion sort, assuming *(begin - 1) is not
+// greater than any element of the range, which drops the bounds check
+template <class Iter, class Compare>
+inline void unguardedInsertionSort(Iter begin, Iter end, Compare comp)
+{
+    typedef typename std::iterator_traits<Iter>::value_type T;
+
+    if (begin == end)
+        return;
+    for (Iter cur = begin + 1; cur != end; ++cur)
+    {
+        Iter sift = cur;
+        Iter sift1 = cur - 1;
+        if (comp(*sift, *sift1))
+        {
+            T tmp = std::move(*sift);
+            do
+                *sift-- = std::move(*sift1);
+            while (comp(tmp, *--sift1));
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// Attempts insertion sort on [begin, end), giving up once more than
+// PARTIAL_INSERTION_SORT_LIMIT elements had to move. Returns true if sorted.
+template <class Iter, class Compare>
+inline bool partialInsertionSort(Iter begin, Iter end, Compare comp)
+{
+    typedef typename std::iterator_traits<Iter>::value_type T;
+    std::size_t limit = 0;
+
+    if (begin == end)
+        return true;
+    for (Iter cur = begin + 1; cur != end; ++cur)
+    {
+        Iter sift = cur;
+        Iter sift1 = cur - 1;
+        if (comp(*sift, *sift1))
+        {
+            T tmp = std::move(*sift);
+            do
+                *sift-- = std::move(*sift1);
+            while (sift != begin && comp(tmp, *--sift1));
+            *sift = std::move(tmp);
+            limit += cur - sift;
+        }
+        if (limit > PARTIAL_INSERTION_SORT_LIMIT)
+            return false;
+    }
+    return true;
+}
+
+template <class Iter, class Compare>
+inline void sort2(Iter a, Iter b, Compare comp)
+{
+    if (comp(*b, *a))
+        std::iter_swap(a, b);
+}
+
+// Sorts the elements *a, *b and *c
+template <class Iter, class Compare>
+inline void sort3(Iter a, Iter b, Iter c, Compare comp)
+{
+    sort2(a, b, comp);
+    sort2(b, c, comp);
+    sort2(a, b, comp);
+}
+
+template <class T>
+inline T *alignCacheline(T *p)
+{
+    std::uintptr_t ip = reinterpret_cast<std::uintptr_t>(p);
+    ip = (ip + CACHELINE_SIZE - 1) & ~static_cast<std::uintptr_t>(CACHELINE_SIZE - 1);
+    return reinterpret_cast<T *>(ip);
+}
+
+// Swaps the elements misplaced on the left with those misplaced on the right.
+// With equal counts plain swaps are needed to keep descending input O(n),
+// otherwise a cyclic permutation moves each element once.
+template <class Iter>
+inline void swapOffsets(Iter first, Iter last, unsigned char *offsetsL, unsigned char *offsetsR,
+                        std::size_t num, bool useSwaps)
+{
+    typedef typename std::iterator_traits<Iter>::value_type T;
+
+    if (useSwaps)
+    {
+        for (std::size_t i = 0; i < num; ++i)
+            std::iter_swap(first + offsetsL[i], last - offsetsR[i]);
+    }
+    else if (num > 0)
+    {
+        Iter l = first + offsetsL[0];
+        Iter r = last - offsetsR[0];
+        T tmp(std::move(*l));
+        *l = std::move(*r);
+        for (std::size_t i = 1; i < num; ++i)
+        {
+            l = first + offsetsL[i];
+            *r = std::move(*l);
+            r = last - offsetsR[i];
+            *l = std::move(*r);
+        }
+        *r = std::move(tmp);
+    }
+}
+
+// Partitions [begin, end) around the pivot *begin. Elements equal to the
+// pivot go to the right. Returns the pivot position and whether the range
+// was already partitioned. Assumes the range holds at least 3 elements and
+// the pivot is a median of 3, so both scans stop without bounds checks.
+template <class Iter, class Compare>
+inline std::pair<Iter, bool> partitionRightBranchless(Iter begin, Iter end, Compare comp)
+{
+    typedef typename std::iterator_traits<Iter>::value_type T;
+
+    T pivot(std::move(*begin));
+    Iter first = begin;
+    Iter last = end;
+
+    // find the first element not less than the pivot, and the last element
+    // less than it (guarded only if nothing moved on the left)
+    while (comp(*++first, pivot))
+        ;
+    if (first - 1 == begin)
+        while (first < last && !comp(*--last, pivot))
+            ;
+    else
+        while (!comp(*--last, pivot))
+            ;
+
+    bool alreadyPartitioned = first >= last;
+    if (!alreadyPartitioned)
+    {
+        std::iter_swap(first, last);
+        ++first;
+
+        // offsets of misplaced elements in the current left and right blocks
+        unsigned char offsetsLStorage[BLOCK_SIZE + CACHELINE_SIZE];
+        unsigned char offsetsRStorage[BLOCK_SIZE + CACHELINE_SIZE];
+        unsigned char *offsetsL = alignCacheline(offsetsLStorage);
+        unsigned char *offsetsR = alignCacheline(offsetsRStorage);
+
+        Iter offsetsLBase = first;
+        Iter offsetsRBase = last;
+        std::size_t numL = 0, numR = 0, startL = 0, startR = 0;
+
+        while (first < last)
+        {
+            // fill whichever block is empty, splitting the rest evenly if both are
+            std::size_t numUnknown = last - first;
+            std::size_t leftSplit = numL == 0 ? (numR == 0 ? numUnknown / 2 : numUnknown) : 0;
+            std::size_t rightSplit = numR == 0 ? (numUnknown - leftSplit) : 0;
+
+            // the comparison result is added, not branched on
+            if (leftSplit >= BLOCK_SIZE)
+                leftSplit = BLOCK_SIZE;
+            for (std::size_t i = 0; i < leftSplit;)
+            {
+                offsetsL[numL] = static_cast<unsigned char>(i++);
+                numL += !comp(*first, pivot);
+                ++first;
+            }
+
+            if (rightSplit >= BLOCK_SIZE)
+                rightSplit = BLOCK_SIZE;
+            for (std::size_t i = 0; i < rightSplit;)
+            {
+                offsetsR[numR] = static_cast<unsigned char>(++i);
+                numR += comp(*--last, pivot);
+            }
+
+            std::size_t num = std::min(numL, numR);
+            swapOffsets(offsetsLBase, offsetsRBase, offsetsL + startL, offsetsR + startR, num,
+                        numL == numR);
+            numL -= num;
+            numR -= num;
+            startL += num;
+            startR += num;
+            if (numL == 0)
+            {
+                startL = 0;
+                offsetsLBase = first;
+            }
+            if (numR == 0)
+            {
+                startR = 0;
+                offsetsRBase = last;
+            }
+        }
+
+        // one block may still hold misplaced elements, move them next to
+        // the boundary
+        if (numL)
+        {
+            offsetsL += startL;
+            while (numL--)
+                std::iter_swap(offsetsLBase + offsetsL[numL], --last);
+            first = last;
+        }
+        if (numR)
+        {
+            offsetsR += startR;
+            while (numR--)
+                std::iter_swap(offsetsRBase - offsetsR[numR], first), ++first;
+            last = first;
+        }
+    }
+
+    Iter pivotPos = first - 1;
+    *begin = std::move(*pivotPos);
+    *pivotPos = std::move(pivot);
+    return std::make_pair(pivotPos, alreadyPartitioned);
+}
+
+// Same contract as partitionRightBranchless, with a classic Hoare scan
+template <class Iter, class Compare>
+inline std::pair<Iter, bool> partitionRight(Iter begin, Iter end, Compare comp)
+{
+    typedef typename std::iterator_traits<Iter>::value_type T;
+
+    T pivot(std::move(*begin));
+    Iter first = begin;
+    Iter last = end;
+
+    while (comp(*++first, pivot))
+        ;
+    if (first - 1 == begin)
+        while (first < last && !comp(*--last, pivot))
+            ;
+    else
+        while (!comp(*--last, pivot))
+            ;
+
+    bool alreadyPartitioned = first >= last;
+    while (first < last)
+    {
+        std::iter_swap(first, last);
+        while (comp(*++first, pivot))
+            ;
+        while (!comp(*--last, pivot))
+            ;
+    }
+
+    Iter pivotPos = first - 1;
+    *begin = std::move(*pivotPos);
+    *pivotPos = std::move(pivot);
+    return std::make_pair(pivotPos, alreadyPartitioned);
+}
+
+// Partitions [begin, end) around the pivot *begin with elements equal to the
+// pivot going to the left. Used when the pivot equals the element before the
+// range: everything equal is then already in its final place, so runs of
+// duplicate keys are handled in linear time.
+template <class Iter, class Compare>
+inline Iter partitionLeft(Iter begin, Iter end, Compare comp)
+{
+    typedef typename std::iterator_traits<Iter>::value_type T;
+
+    T pivot(std::move(*begin));
+    Iter first = begin;
+    Iter last = end;
+
+    while (comp(pivot, *--last))
+        ;
+    if (last + 1 == end)
+        while (first < last && !comp(pivot, *++first))
+            ;
+    else
+        while (!comp(pivot, *++first))
+            ;
+
+    while (first < last)
+    {
+        std::iter_swap(first, last);
+        while (comp(pivot, *--last))
+            ;
+        while (!comp(pivot, *++first))
+            ;
+    }
+
+    Iter pivotPos = last;
+    *begin = std::move(*pivotPos);
+    *pivotPos = std::move(pivot);
+    return pivotPos;
+}
+
+// Breaks up patterns that made a partition unbalanced by swapping a few
+// elements into the positions future pivots are picked from
+template <class Iter>
+inline void shuffle(Iter begin, Iter pivotPos, Iter end)
+{
+    typedef typename std::iterator_traits<Iter>::difference_type diff_t;
+    diff_t lSize = pivotPos - begin;
+    diff_t rSize = end - (pivotPos + 1);
+
+    if (lSize >= INSERTION_SORT_THRESHOLD)
+    {
+        std::iter_swap(begin, begin + lSize / 4);
+        std::iter_swap(pivotPos - 1, pivotPos - lSize / 4);
+        if (lSize > NINTHER_THRESHOLD)
+        {
+            std::iter_swap(begin + 1, begin + (lSize / 4 + 1));
+            std::iter_swap(begin + 2, begin + (lSize / 4 + 2));
+            std::iter_swap(pivotPos - 2, pivotPos - (lSize / 4 + 1));
+            std::iter_swap(pivotPos - 3, pivotPos - (lSize / 4 + 2));
+        }
+    }
+    if (rSize >= INSERTION_SORT_THRESHOLD)
+    {
+        std::iter_swap(pivotPos + 1, pivotPos + (1 + rSize / 4));
+        std::iter_swap(end - 1, end - rSize / 4);
+        if (rSize > NINTHER_THRESHOLD)
+        {
+            std::iter_swap(pivotPos + 2, pivotPos + (2 + rSize / 4));
+            std::iter_swap(pivotPos + 3, pivotPos + (3 + rSize / 4));
+            std::iter_swap(end - 2, end - (1 + rSize / 4));
+            std::iter_swap(end - 3, end - (2 + rSize / 4));
+        }
+    }
+}
+
+// Sorts [begin, end). badAllowed counts the unbalanced partitions left before
+// switching to heapsort. leftmost is false when *(begin - 1) belongs to the
+// sorted output and bounds the range from below. The smaller side of each
+// partition is sorted recursively and the larger one by looping, which keeps
+// the stack O(log n) on any input.
+template <class Iter, class Compare, bool Branchless>
+inline void pdqsortLoop(Iter begin, Iter end, Compare comp, int badAllowed, bool leftmost = true)
+{
+    typedef typename std::iterator_traits<Iter>::difference_type diff_t;
+
+    while (true)
+    {
+        diff_t size = end - begin;
+
+        if (size < INSERTION_SORT_THRESHOLD)
+        {
+            if (leftmost)
+                insertionSort(begin, end, comp);
+            else
+                unguardedInsertionSort(begin, end, comp);
+            return;
+        }
+
+        // move the median of 3 (or the ninther) to begin as the pivot
+        diff_t s2 = size / 2;
+        if (size > NINTHER_THRESHOLD)
+        {
+            sort3(begin, begin + s2, end - 1, comp);
+            sort3(begin + 1, begin + (s2 - 1), end - 2, comp);
+            sort3(begin + 2, begin + (s2 + 1), end - 3, comp);
+            sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1), comp);
+            std::iter_swap(begin, begin + s2);
+        }
+        else
+            sort3(begin + s2, begin, end - 1, comp);
+
+        // nothing in the range is less than *(begin - 1); if the pivot equals
+        // it, put the duplicates left and only the greater elements remain
+        if (!leftmost && !comp(*(begin - 1), *begin))
+        {
+            begin = partitionLeft(begin, end, comp) + 1;
+            continue;
+        }
+
+        std::pair<Iter, bool> result = Branchless ? partitionRightBranchless(begin, end, comp)
+                                                  : partitionRight(begin, end, comp);
+        Iter pivotPos = result.first;
+        bool alreadyPartitioned = result.second;
+
+        diff_t lSize = pivotPos - begin;
+        diff_t rSize = end - (pivotPos + 1);
+        if (lSize < size / 8 || rSize < size / 8)
+        {
+            if (--badAllowed == 0)
+            {
+                std::make_heap(begin, end, comp);
+                std::sort_heap(begin, end, comp);
+                return;
+            }
+            shuffle(begin, pivotPos, end);
+        }
+        else if (alreadyPartitioned && partialInsertionSort(begin, pivotPos, comp)
+                 && partialInsertionSort(pivotPos + 1, end, comp))
+            return;
+
+        if (lSize < rSize)
+        {
+            pdqsortLoop<Iter, Compare, Branchless>(begin, pivotPos, comp, badAllowed, leftmost);
+            begin = pivotPos + 1;
+            leftmost = false;
+        }
+        else
+        {
+            pdqsortLoop<Iter, Compare, Branchless>(pivotPos + 1, end, comp, badAllowed, false);
+            end = pivotPos;
+        }
+    }
+}
+
+} // namespace detail
+
+template <class Iter, class Compare>
+inline void pdqsort(Iter begin, Iter end, Compare comp)
+{
+    if (end - begin < 2)
+        return;
+    detail::pdqsortLoop<Iter, Compare, false>(begin, end, comp, detail::log2(end - begin));
+}
+
+template <class Iter>
+inline void pdqsort(Iter begin, Iter end)
+{
+    pdqsort(begin, end, std::less<typename std::iterator_traits<Iter>::value_type>());
+}
+
+template <class Iter, class Compare>
+inline void pdqsortBranchless(Iter begin, Iter end, Compare comp)
+{
+    if (end - begin < 2)
+        return;
+    detail::pdqsortLoop<Iter, Compare, true>(begin, end, comp, detail::log2(end - begin));
+}
+
+template <class Iter>
+inline void pdqsortBranchless(Iter begin, Iter end)
+{
+    pdqsortBranchless(begin, end, std::less<typename std::iterator_traits<Iter>::value_type>());
+}
+
+// Sorts by the key keyOf extracts from each element, e.g. a column of the
+// bid a row number refers to. Arithmetic keys use the branchless partition.
+template <class Iter, class KeyOf>
+inline void pdqsortByKey(Iter begin, Iter end, KeyOf keyOf)
+{
+    typedef typename std::iterator_traits<Iter>::value_type T;
+    typedef typename std::decay<decltype(keyOf(*begin))>::type Key;
+
+    auto less = [&keyOf](const T &a, const T &b) { return keyOf(a) < keyOf(b); };
+    if constexpr (std::is_arithmetic<Key>::value)
+        pdqsortBranchless(begin, end, less);
+    else
+        pdqsort(begin, end, less);
+}
+
+} // namespace pdq
+
+#endif /*!_PDQSORT_HPP_*/
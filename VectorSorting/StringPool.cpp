@@ -0,0 +1,35 @@
+#include "StringPool.hpp"
+
+// Constructor for the StringPool class
+StringPool::StringPool(void)
+{
+    _strings.push_back(std::string_view());
+    _index.emplace(std::string_view(), 0);
+}
+
+// Function to get the handle of a value, storing it on first sight
+uint32_t StringPool::intern(std::string_view value)
+{
+    std::unordered_map<std::string_view, uint32_t>::const_iterator it = _index.find(value);
+
+    if (it != _index.end())
+        return it->second;
+
+    std::string_view stored = _bytes.store(value);
+    uint32_t handle = static_cast<uint32_t>(_strings.size());
+    _strings.push_back(stored);
+    _index.emplace(stored, handle);
+    return handle;
+}
+
+// Function to get the value of a handle
+std::string_view StringPool::view(uint32_t handle) const
+{
+    return _strings[handle];
+}
+
+// Function to get the number of distinct values (including the empty string)
+uint32_t StringPool::size(void) const
+{
+    return static_cast<uint32_t>(_strings.size());
+}
@@ -0,0 +1,31 @@
+#ifndef     _STRINGPOOL_HPP_
+# define    _STRINGPOOL_HPP_
+
+# include <cstdint>
+# include <string_view>
+# include <unordered_map>
+# include <vector>
+# include "CSVparser.hpp"
+
+// Interned strings: every distinct value is stored once and named by a small
+// integer handle. Handle 0 is always the empty string.
+class StringPool
+{
+  public:
+    StringPool(void);
+
+    StringPool(const StringPool &) = delete;
+    StringPool &operator=(const StringPool &) = delete;
+
+  public:
+    uint32_t intern(std::string_view);
+    std::string_view view(uint32_t) const;
+    uint32_t size(void) const;
+
+  private:
+    csv::Arena _bytes;
+    std::vector<std::string_view> _strings;
+    std::unordered_map<std::string_view, uint32_t> _index;
+};
+
+#endif /*!_STRINGPOOL_HPP_*/
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include "ThreadPool.hpp"
+
+// Constructor for the ThreadPool class, the caller of run() counts as a
+// thread so one fewer worker is started
+ThreadPool::ThreadPool(unsigned int threads)
+  : _stop(false)
+{
+    if (threads == 0)
+        threads = hardwareThreads();
+    for (unsigned int i = 1; i < threads; i++)
+        _workers.emplace_back(&ThreadPool::work, this);
+}
+
+// Destructor for the ThreadPool class, lets queued jobs finish
+ThreadPool::~ThreadPool(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (auto it = _workers.begin(); it != _workers.end(); it++)
+        it->join();
+}
+
+// Function to get the number of threads taking part in run()
+unsigned int ThreadPool::size(void) const
+{
+    return static_cast<unsigned int>(_workers.size()) + 1;
+}
+
+// Function to get the number of hardware threads (at least 1)
+unsigned int ThreadPool::hardwareThreads(void)
+{
+    unsigned int count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
+
+// Function to queue a job for the workers
+void ThreadPool::submit(std::function<void(void)> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(std::move(job));
+    }
+    _wake.notify_one();
+}
+
+// Worker loop: take jobs until the pool is stopped and drained
+void ThreadPool::work(void)
+{
+    for (;;)
+    {
+        std::function<void(void)> job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [this] { return _stop || !_jobs.empty(); });
+            if (_jobs.empty())
+                return;
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+        job();
+    }
+}
+
+// Function to run task(0) .. task(count - 1) on the pool and wait for them
+void ThreadPool::run(size_t count, const std::function<void(size_t)> &task)
+{
+    if (count == 0)
+        return;
+
+    // every participant pulls indices from a shared counter until none are left
+    struct Batch
+    {
+        std::atomic<size_t> next;
+        std::atomic<size_t> done;
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+    std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+    batch->next = 0;
+    batch->done = 0;
+
+    std::function<void(void)> drain = [batch, count, &task]() {
+        size_t i;
+        while ((i = batch->next++) < count)
+        {
+            try {
+                task(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(batch->mutex);
+                if (!batch->error)
+                    batch->error = std::current_exception();
+            }
+            if (++batch->done == count)
+            {
+                std::lock_guard<std::mutex> lock(batch->mutex);
+                batch->finished.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min(count - 1, _workers.size());
+    for (size_t i = 0; i < helpers; i++)
+        submit(drain);
+    drain();
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->finished.wait(lock, [&batch, count] { return batch->done == count; });
+    if (batch->error)
+        std::rethrow_exception(batch->error);
+}
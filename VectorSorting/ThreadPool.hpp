@@ -0,0 +1,44 @@
+#ifndef     _THREADPOOL_HPP_
+# define    _THREADPOOL_HPP_
+
+# include <condition_variable>
+# include <cstddef>
+# include <deque>
+# include <functional>
+# include <mutex>
+# include <thread>
+# include <vector>
+
+// Fixed set of worker threads fed from a single job queue
+class ThreadPool
+{
+  public:
+    ThreadPool(unsigned int threads = 0);   // 0 = one per hardware thread
+    ~ThreadPool(void);
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+  public:
+    unsigned int size(void) const;
+
+    // Run task(i) for every i in [0, count) and wait until all are done. The
+    // calling thread takes part, so run() may also be called from inside a task.
+    // The first exception thrown by a task is rethrown here.
+    void run(size_t count, const std::function<void(size_t)> &task);
+
+    static unsigned int hardwareThreads(void);
+
+  protected:
+    void submit(std::function<void(void)>);
+    void work(void);
+
+  private:
+    std::vector<std::thread> _workers;
+    std::deque<std::function<void(void)>> _jobs;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    bool _stop;
+};
+
+#endif /*!_THREADPOOL_HPP_*/
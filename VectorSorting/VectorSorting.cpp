@@ -7,14 +7,30 @@
 //============================================================================
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cstdlib>
+#include <filesystem>
 #include <ctime>
 #include <sstream>
 #include <iomanip>
+#include <limits>
 #include <time.h>
 #include "CSVparser.hpp"
+#include "Bid.hpp"
+#include "BidAggregate.hpp"
+#include "BidFilter.hpp"
+#include "BidIndex.hpp"
+#include "BidLoader.hpp"
+#include "BidSort.hpp"
+#include "ExternalSort.hpp"
+#include "OutputWriter.hpp"
+#include "PdqSort.hpp"
+#include "ThreadPool.hpp"
 
 using namespace std;
 
@@ -23,26 +39,8 @@ using namespace std;
 // Global definitions visible to all methods and classes
 //============================================================================
 
-// forward declarations
-double strToDouble(string str, char ch);
-
-
-// define a structure to hold bid information
-struct Bid {
-    string bidId; // unique identifier
-    string title;
-    string department;
-    string closeDate;
-    string fund;
-    double amount;
-    string inventoryID;
-    string vehicleID;
-    string receiptNumber;
-
-    Bid() {
-        amount = 0.0;
-    }
-};
+// Rows shown before bid listings wait for Enter, 0 shows them all at once
+static size_t pageRows = 0;
 
 //============================================================================
 // Static methods used for testing
@@ -51,11 +49,16 @@ struct Bid {
 /**
  * Display the bid information to the console (std::out)
  *
+ * @param out buffered writer to the console
  * @param bid struct containing the bid info
  */
-void displayBid(Bid bid) {
-    std::cout << bid.bidId << ": " << bid.title << " | " << bid.amount << " | "
-            << bid.fund << endl;
+void displayBid(OutputWriter& out, const Bid& bid) {
+    // a missing ID shows as an empty field, like a missing date
+    if (bid.bidId != Bid::MISSING) {
+        out << bid.bidId;
+    }
+    out << ": " << text(bid.title) << " | " << bid.amount / 100.0 << " | "
+        << bidFunds.decode(bid.fund) << '\n';
     return;
 }
 
@@ -69,174 +72,84 @@ Bid getBid() {
 
     std::cout << "Enter Id: ";
     cin.ignore();
-    getline(cin, bid.bidId);
+    string strId;
+    getline(cin, strId);
+    long long id;
+    if (csv::toInteger(strId, id) == std::errc() && id >= 0 && id < Bid::MISSING) {
+        bid.bidId = static_cast<uint32_t>(id);
+    }
 
     std::cout << "Enter title: ";
-    getline(cin, bid.title);
+    string title;
+    getline(cin, title);
+    bid.title = bidStrings.intern(title);
 
     std::cout << "Enter fund: ";
-    cin >> bid.fund;
+    string fund;
+    cin >> fund;
+    bid.fund = bidFunds.encode(fund);
 
     std::cout << "Enter amount: ";
     cin.ignore();
     string strAmount;
     getline(cin, strAmount);
-    bid.amount = strToDouble(strAmount, '$');
-
-    return bid;
-}
-
-/**
- * Load a CSV file containing bids into a container
- *
- * @param csvPath the path to the CSV file to load
- * @return a container holding all the bids read
- */
-vector<Bid> loadBids(string csvPath) {
-    std::cout << "Loading CSV file " << csvPath << endl;
-
-    // Define a vector data structure to hold a collection of bids.
-    vector<Bid> bids;
-
-    // initialize the CSV Parser using the given path
-    csv::Parser file = csv::Parser(csvPath);
-
-    try {
-        // loop to read rows of a CSV file
-        for (int i = 0; i < file.rowCount(); i++) {
-
-            // Create a data structure and add to the collection of bids
-            Bid bid;
-            bid.bidId = file[i][1];
-            bid.title = file[i][0];
-            bid.department = file[i][2];
-            bid.closeDate = file[i][3];
-            bid.amount = strToDouble(file[i][4], '$');
-            bid.inventoryID = file[i][5];
-            bid.vehicleID = file[i][6];
-            bid.receiptNumber = file[i][7];
-            bid.fund = file[i][8];
-
-
-            //cout << "Item: " << bid.title << ", Fund: " << bid.fund << ", Amount: " << bid.amount << endl;
-
-            // Debug statment to check department field
-            //std::cout << "Loaded Bid: " << bid.bidId << " | VehicleID: " << bid.vehicleID << std::endl;
-
-            // push this bid to the end
-            bids.push_back(bid);
-        }
-    } catch (csv::Error &e) {
-        std::cerr << e.what() << std::endl;
-    }
-    catch (std::exception& e) {
-        std::cerr << e.what() << std::endl;
+    long long cents;
+    if (csv::toCents(strAmount, cents) == std::errc()) {
+        bid.amount = cents;
     }
-    return bids;
-}
-
-// FIXME (2a): Implement the quick sort logic over bid.title
 
-/**
- * Partition the vector of bids into two parts, low and high
- *
- * @param bids Address of the vector<Bid> instance to be partitioned
- * @param begin Beginning index to partition
- * @param end Ending index to partition
- */
-int partition(vector<Bid>& bids, int begin, int end) {
-    //set low and high equal to begin and end
-    int low = begin;
-    int high = end;
-    // pick the middle element as pivot point
-    int mid = begin + (end - begin) / 2;
-    string pivot = bids[mid].title;
-    // while not done 
-    while (true) {
-        // keep incrementing low index while bids[low] < bids[pivot]
-        while (bids[low].title < pivot) {
-            low++;
-        }
-        // keep decrementing high index while bids[high] > bids[pivot]
-        while (bids[high].title > pivot) {
-            high--;
-        }
-        /* If there are zero or one elements remaining,
-            all bids are partitioned. Return high */
-        if (low >= high) {
-            break;
-        }
-        // else swap the low and high bids (built in vector method)
-        else {
-            swap(bids[low], bids[high]);
-        }
-        // move low and high closer ++low, --high
-        ++low;
-        --high;
-    }
-    //return high;
-    return high;
+    return bid;
 }
 
 /**
  * Perform a quick sort on bid title
+ * Pattern-defeating quicksort (PdqSort.hpp)
  * Average performance: O(n log(n))
- * Worst case performance O(n^2))
+ * Worst case performance O(n log(n))
  *
- * @param bids address of the vector<Bid> instance to be sorted
+ * @param bids the bid table the rows refer to
+ * @param rows address of the row numbers to be sorted
  * @param begin the beginning index to sort on
  * @param end the ending index to sort on
  */
-void quickSort(vector<Bid>& bids, int begin, int end) {
-    //set mid equal to 0
-    /* Base case: If there are 1 or zero bids to sort,
-     partition is already sorted otherwise if begin is greater
-     than or equal to end then return*/
+void quickSort(const vector<Bid>& bids, vector<uint32_t>& rows, int begin, int end) {
+    // Base case: If there are 1 or zero bids to sort, nothing to do
     if (begin >= end) {
         return;
     }
-    /* Partition bids into low and high such that
-     midpoint is location of last element in low */
-    int pivotIndex = (begin + end) / 2;
-    string pivot = bids[pivotIndex].title;
-
-    int i = begin;
-    int j = end;
-    
-    while (i <= j) {
-        // recursively sort low partition (begin to mid)
-        while (bids[i].title > pivot) {
-            i++;
-        }
-        // recursively sort high partition (mid+1 to end)
-        while (bids[j].title > pivot) {
-            j--;
-        }
-        if (i <= j) {
-            swap(bids[i], bids[j]);
-            i++;
-            j--;
-        }
-    }
-    quickSort(bids, begin, j);
-    quickSort(bids, i, end);
+    // equal titles keep ascending row order, as argsort leaves them
+    pdq::pdqsortByKey(rows.begin() + begin, rows.begin() + end + 1,
+        [&bids](uint32_t row) { return make_pair(text(bids[row].title), row); });
 }
 
-// FIXME (1a): Implement the selection sort logic over bid.title
+/**
+ * Perform a parallel merge sort on bid title
+ * Views smaller than PARALLEL_SORT_CUTOFF are sorted on this thread
+ * Average performance: O(n log(n) / threads)
+ * Worst case performance O(n log(n))
+ *
+ * @param bids the bid table the rows refer to
+ * @param rows address of the row numbers to be sorted
+ * @param pool the threads to sort with
+ */
+void parallelSort(const vector<Bid>& bids, vector<uint32_t>& rows, ThreadPool& pool) {
+    argsort(bids, rows, eTITLE, false, &pool);
+}
 
 /**
  * Perform a selection sort on bid title
  * Average performance: O(n^2))
  * Worst case performance O(n^2))
  *
- * @param bid address of the vector<Bid>
- *            instance to be sorted
+ * @param bids the bid table the rows refer to
+ * @param rows address of the row numbers to be sorted
  */
-void selectionSort(vector<Bid>& bids) {
-    //define min as int (index of the current minimum bid)
-    unsigned int min;
-    // check size of bids vector
-    unsigned int size = bids.size();
+void selectionSort(const vector<Bid>& bids, vector<uint32_t>& rows) {
+    // check size of rows vector, fewer than two rows are already sorted
+    size_t size = rows.size();
+    if (size < 2) {
+        return;
+    }
     // set size_t platform-neutral result equal to bid.size()
     // pos is the position within bids that divides sorted/unsorted
     // for size_t pos = 0 and less than size -1 
@@ -246,30 +159,53 @@ void selectionSort(vector<Bid>& bids) {
         // loop over remaining elements to the right of position
         for (size_t j = pos + 1; j < size; ++j) {
             // if this element's title is less than minimum title
-            if (bids[j].title.compare(bids[min].title) < 0) {
+            if (text(bids[rows[j]].title).compare(text(bids[rows[min]].title)) < 0) {
                 // this element becomes the minimum
                 min = j;
             }
         }
         // swap the current minimum with smaller one found
         if (min != pos) {
-            // swap is a built in vector method
-            swap(bids[pos], bids[min]);
+            // swap row numbers, the bids stay in place
+            swap(rows[pos], rows[min]);
         }
     }
 }
 
-void displayFilterMenu(vector<Bid>& bids); 
-void filterByFund(vector<Bid>& bids);
-
-void displayFilteredBids(vector<Bid>& bids, int filterChoice);
-
-
-// Bid Filtering
-void displayFilterMenu(vector<Bid>& bids) {
+void displayFilterMenu(const vector<Bid>& bids, vector<uint32_t>& rows, ViewOrder& order,
+                       const BidColumnStore& columns, ThreadPool& pool);
+void displayRangeQuery(const vector<Bid>& bids, const vector<uint32_t>& rows);
+void findBids(const vector<Bid>& bids, const BidIndex& index);
+void displayIndexRange(const vector<Bid>& bids, const BidIndex& index);
+void filterBids(const vector<Bid>& bids, const BidColumnStore& columns);
+void displaySalesReport(const BidColumnStore& columns, ThreadPool& pool);
+vector<string> readPaths(void);
+vector<string> appendFiles(const vector<string>& paths, vector<Bid>& bids, vector<uint32_t>& rows,
+                           const ViewOrder& order, BidIndex& index, BidColumnStore& columns, ThreadPool& pool,
+                           vector<string>& failed);
+void enterBid(vector<Bid>& bids, vector<uint32_t>& rows, const ViewOrder& order, BidIndex& index,
+              BidColumnStore& columns);
+void removeBids(vector<Bid>& bids, vector<uint32_t>& rows, BidIndex& index, BidColumnStore& columns);
+
+void displayFilteredBids(const vector<Bid>& bids, const vector<uint32_t>& rows, int filterChoice);
+
+
+// Bid Filtering, sorts reorder the rows of the view and leave the table as loaded
+void displayFilterMenu(const vector<Bid>& bids, vector<uint32_t>& rows, ViewOrder& order,
+                       const BidColumnStore& columns, ThreadPool& pool) {
     // Debug statement
     // std::cout << "Entering displayFilterMenu" << std::endl;
     int filterChoice = 0;
+    // radix sorts order the view exactly like the comparison sorts
+    bool radix = false;
+    auto sortBy = [&](SortKey key, bool descending) {
+        if (radix) {
+            radixArgsort(bids, rows, key, descending);
+        } else {
+            argsort(bids, rows, key, descending, &pool);
+        }
+        order = ViewOrder{ true, key, descending };
+    };
     while (true) {
         std::cout << "Filter by:" << endl;
         std::cout << " 1. ArticleTitle" << endl;
@@ -280,17 +216,19 @@ void displayFilterMenu(vector<Bid>& bids) {
         std::cout << " 6. InventoryID" << endl;
         std::cout << " 7. VehicleID" << endl;
         std::cout << " 8. ReceiptNumber" << endl;
-        std::cout << " 9. Fund" << endl;
+        std::cout << " 9. Filter by Conditions" << endl;
+        std::cout << " 10. Sort method: " << (radix ? "Radix" : "Comparison") << " (toggle)" << endl;
+        std::cout << " 11. Top N / Row Range" << endl;
         std::cout << " 0. Exit" << endl;
         std::cout << "Enter choice: ";
 
         // Clear input buffer of unwanted characters
         std::cin >> filterChoice;
 
-        if (!std::cin || filterChoice < 0 || filterChoice > 9) {
+        if (!std::cin || filterChoice < 0 || filterChoice > 11) {
             std::cin.clear();
             std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            std::cout << "Invalid input. Please enter a number between 0 and 9." << std::endl;
+            std::cout << "Invalid input. Please enter a number between 0 and 11." << std::endl;
             continue;
         }
 
@@ -301,175 +239,536 @@ void displayFilterMenu(vector<Bid>& bids) {
             break;
         }
 
+        if (filterChoice == 10) {
+            radix = !radix;
+            std::cout << "Sort method: " << (radix ? "Radix" : "Comparison") << std::endl;
+            continue;
+        }
+
+        if (filterChoice == 11) {
+            displayRangeQuery(bids, rows);
+            continue;
+        }
+
+        // every sort key was parsed once when the bids were read
         switch (filterChoice) {
         case 1:
-            sort(bids.begin(), bids.end(), [](Bid a, Bid b) { return a.title < b.title; });
+            sortBy(eTITLE, false);
             std::cout << "Sorted by ArticleTitle" << endl;
             break;
 
         case 2:
-            sort(bids.begin(), bids.end(), [](Bid a, Bid b) { return stoi(a.bidId) < stoi(b.bidId); });
+            sortBy(eBIDID, false);
             std::cout << "Sorted by ArticleID" << endl;
             break;
 
         case 3:
-            sort(bids.begin(), bids.end(), [](Bid a, Bid b) { return a.department < b.department; });
+            sortBy(eDEPARTMENT, false);
             std::cout << "Sorted by Department" << endl;
             break;
 
         case 4:
-            sort(bids.begin(), bids.end(), [](Bid a, Bid b) {
-                std::tm dateA = csv::parseDate(a.closeDate);
-                std::tm dateB = csv::parseDate(b.closeDate);
-                return std::mktime(&dateA) > std::mktime(&dateB);
-                });
+            sortBy(eCLOSEDATE, true);
             std::cout << "Sorted by CloseDate" << endl;
             break;
 
         case 5:
-            sort(bids.begin(), bids.end(), [](Bid a, Bid b) { return a.amount < b.amount; });
+            sortBy(eAMOUNT, false);
             std::cout << "Sorted by WinningBid" << endl;
             break;
 
         case 6:
-            sort(bids.begin(), bids.end(), [](Bid a, Bid b) {
-                try {
-                    return stoi(a.inventoryID) < stoi(b.inventoryID);
-                }
-                catch (const std::invalid_argument& e) {
-                    std::cerr << "Invalid inventoryID: " << a.inventoryID << " or " << b.inventoryID << std::endl;
-                    return false;
-                }
-                });
+            // bids without a numeric inventoryID sort last
+            sortBy(eINVENTORYID, false);
             std::cout << "Sorted by InventoryID" << std::endl;
             break;
 
         case 7:
-            sort(bids.begin(), bids.end(), [](Bid a, Bid b) {
-                if (a.vehicleID.empty() || b.vehicleID.empty()) {
-                    return false; // Handles empty fields
-                }
-                try {
-                    return stoi(a.vehicleID) < stoi(b.vehicleID);
-                }
-                catch (const std::invalid_argument& e) {
-                    std::cerr << "Invalid vehicleID: " << a.vehicleID << " or " << b.vehicleID << std::endl;
-                    return false;
-                }
-                });
+            sortBy(eVEHICLEID, false);
             std::cout << "Sorted by VehicleID" << std::endl;
             break;
 
         case 8:
-            sort(bids.begin(), bids.end(), [](Bid a, Bid b) {
-                if (!std::all_of(a.receiptNumber.begin(), a.receiptNumber.end(), ::isdigit) ||
-                    !std::all_of(b.receiptNumber.begin(), b.receiptNumber.end(), ::isdigit)) {
-                    std::cerr << "Invalid receiptNumber: " << a.receiptNumber << " or " << b.receiptNumber << std::endl;
-                    return false;
-                }
-                try {
-                    return stoi(a.receiptNumber) < stoi(b.receiptNumber);
-                } catch (const std::invalid_argument& e) {
-                    std::cerr << "Invalid receiptNumber: " << a.receiptNumber << " or " << b.receiptNumber << std::endl;
-                    return false;
-                }
-                catch (const std::out_of_range& e) {
-                    std::cerr << "Out of range receiptNumber: " << a.receiptNumber << " or " << b.receiptNumber << std::endl;
-                    return false;
-                }
-            });
+            sortBy(eRECEIPTNUMBER, false);
             std::cout << "Sorted by receiptNumber" << std::endl;
             break;
 
         case 9:
-            filterByFund(bids);
-            std::cout << "Filtering by Fund" << endl;
-            break;
+            // show the matches only, not the whole view again
+            filterBids(bids, columns);
+            continue;
 
         default:
             std::cout << "Invalid choice. Please enter another option." << endl;
         }
-        displayFilteredBids(bids, filterChoice);
+        displayFilteredBids(bids, rows, filterChoice);
         std::cout << "Displayed filtered bids" << std::endl;
     }
     //std::cout << "Exited the while loop in displayFilterMenu" << std::endl;
 }
 
-void filterByFund(vector<Bid>& bids) {
-    int fundChoice = 0;
-    while (fundChoice != 3) {
-        std::cout << "Select Fund:" << endl;
-        std::cout << " 1. Enterprise" << endl;
-        std::cout << " 2. General Fund" << endl;
-        std::cout << " 3. Exit" << endl;
-        std::cout << "Enter Choice: ";
-        cin >> fundChoice;
-
-        vector<Bid> filteredBids;
-
-        if (fundChoice == 1) { 
-            copy_if(bids.begin(), bids.end(), back_inserter(filteredBids), [](Bid bid) { return bid.fund == "Enterprise"; }); 
-        } else if (fundChoice == 2) { 
-            copy_if(bids.begin(), bids.end(), back_inserter(filteredBids), [](Bid bid) { return bid.fund == "General Fund"; }); 
-        } else if (fundChoice == 3) { 
-            return; 
-        } else { 
-            std::cout << "Invalid choice. Please enter 1, 2, or 3." << endl; 
-        } 
-        displayFilteredBids(filteredBids, 9);
+/**
+ * Display only some rows of a column order, e.g. the 20 highest winning
+ * bids, without sorting or reordering the view
+ *
+ * @param bids the bid table the rows refer to
+ * @param rows the view to query
+ */
+void displayRangeQuery(const vector<Bid>& bids, const vector<uint32_t>& rows) {
+    int column = 0;
+    int order = 0;
+    long long from = 0;
+    long long count = 0;
+
+    std::cout << "Column (1-8, as above): ";
+    cin >> column;
+    std::cout << "Order (1. Ascending, 2. Descending): ";
+    cin >> order;
+    std::cout << "From row (1 = first): ";
+    cin >> from;
+    std::cout << "Number of rows: ";
+    cin >> count;
+
+    if (!cin || column < 1 || column > 8 || order < 1 || order > 2 || from < 1 || count < 0) {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        std::cout << "Invalid query." << endl;
+        return;
     }
+
+    vector<uint32_t> selected = selectRange(bids, rows, static_cast<SortKey>(column), order == 2,
+                                            static_cast<size_t>(from - 1), static_cast<size_t>(count));
+    displayFilteredBids(bids, selected, column);
 }
 
-void displayFilteredBids(vector<Bid>& bids, int filterChoice) {
-    std::cout << "Displaying filtered bids with additional column" << std::endl;
+/**
+ * Look bids up by Auction ID, receipt number or inventory ID
+ *
+ * @param bids the bid table
+ * @param index the indexes over the table
+ */
+void findBids(const vector<Bid>& bids, const BidIndex& index) {
+    int field = 0;
+    string value;
+
+    std::cout << "Find by (1. Auction ID, 2. Receipt Number, 3. Inventory ID): ";
+    cin >> field;
+    std::cout << "Value: ";
+    cin >> value;
+
+    vector<uint32_t> found;
+    long long bidId;
+    if (field == 1 && csv::toInteger(value, bidId) == errc() && bidId >= 0 && bidId < Bid::MISSING) {
+        found = index.findBidId(static_cast<uint32_t>(bidId));
+    } else if (field == 2) {
+        found = index.findReceipt(value);
+    } else if (field == 3) {
+        found = index.findInventory(value);
+    } else {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        std::cout << "Invalid search." << endl;
+        return;
+    }
 
-    for (size_t i = 0; i < bids.size(); ++i) {
-        displayBid(bids[i]);
+    std::cout << found.size() << " bids found" << endl;
+    displayFilteredBids(bids, found, field == 1 ? 2 : field == 2 ? 8 : 6);
+}
 
-        // Display additional column based on filterChoice
-        switch (filterChoice) {
-        case 1: 
-            std::cout << " | ArticleTitle: " << bids[i].title;
+/**
+ * Display the bids with a winning bid or close date in a range
+ *
+ * @param bids the bid table
+ * @param index the indexes over the table
+ */
+void displayIndexRange(const vector<Bid>& bids, const BidIndex& index) {
+    int field = 0;
+    string low;
+    string high;
+
+    std::cout << "Range of (1. WinningBid, 2. CloseDate): ";
+    cin >> field;
+    std::cout << "From (e.g. 100.00 or 1/1/2014): ";
+    cin >> low;
+    std::cout << "To: ";
+    cin >> high;
+
+    vector<uint32_t> found;
+    long long lowCents, highCents;
+    int firstDay, lastDay;
+    if (field == 1 && csv::toCents(low, lowCents) == errc() && csv::toCents(high, highCents) == errc()) {
+        found = index.amountRange(lowCents, highCents);
+    } else if (field == 2 && csv::toDate(low, firstDay) == errc() && csv::toDate(high, lastDay) == errc()) {
+        found = index.closeDateRange(firstDay, lastDay);
+    } else {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        std::cout << "Invalid range." << endl;
+        return;
+    }
+
+    std::cout << found.size() << " bids found" << endl;
+    displayFilteredBids(bids, found, field == 1 ? 5 : 4);
+}
+
+/**
+ * Display count, total, average, lowest and highest of a money column per
+ * department, fund or close month
+ *
+ * @param columns the bid table as columns
+ * @param pool threads to total the report with
+ */
+void displaySalesReport(const BidColumnStore& columns, ThreadPool& pool) {
+    static const char* const measureNames[MEASURES] = {
+        "WinningBid", "CCFee", "AuctionFeeTotal", "Expenses", "NetSales"
+    };
+    int group = 0;
+    int measure = 0;
+
+    std::cout << "Group by (1. Department, 2. Fund, 3. Close Month): ";
+    cin >> group;
+    std::cout << "Column (1. WinningBid, 2. CCFee, 3. AuctionFeeTotal, 4. Expenses, 5. NetSales): ";
+    cin >> measure;
+
+    if (!cin || group < 1 || group > 3 || measure < 1 || measure > MEASURES) {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        std::cout << "Invalid report." << endl;
+        return;
+    }
+
+    GroupBy groupBy = static_cast<GroupBy>(group - 1);
+    Measure column = static_cast<Measure>(measure - 1);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<GroupTotals> groups = aggregate(columns, groupBy, &pool);
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    std::cout << measureNames[column] << " by "
+              << (groupBy == eGROUP_DEPARTMENT ? "Department" : groupBy == eGROUP_FUND ? "Fund" : "Close Month")
+              << endl;
+    for (const GroupTotals& totals : groups) {
+        std::cout << groupName(groupBy, totals.key) << " | Count: " << totals.count
+                  << " | Sum: " << centsText(totals.sum[column])
+                  << " | Avg: " << centsText(static_cast<int64_t>(llround(totals.average(column))))
+                  << " | Min: " << centsText(totals.min[column])
+                  << " | Max: " << centsText(totals.max[column]) << endl;
+    }
+    std::cout << groups.size() << " groups" << endl;
+    std::cout << "Report time: " << elapsed.count() << " seconds" << endl;
+}
+
+/**
+ * Read file and directory paths, one per line up to an empty line
+ */
+vector<string> readPaths(void) {
+    vector<string> paths;
+    string path;
+
+    std::cout << "CSV files or directories, one per line, empty line to finish:" << endl;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    while (getline(cin, path) && !path.empty()) {
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+/**
+ * Read CSV files concurrently and add their bids to the table, skipping
+ * Auction IDs already loaded. Only the new files are parsed; the view,
+ * the indexes and the column store take in the new rows instead of being
+ * rebuilt.
+ *
+ * @param paths files and directories of CSV files
+ * @param bids the bid table
+ * @param rows the view, kept in its order
+ * @param order how the view is ordered
+ * @param index the indexes over the table
+ * @param columns the bid table as columns
+ * @param pool threads to read the files with
+ * @param failed receives the CSV files that couldn't be read
+ * @return the CSV files read
+ */
+vector<string> appendFiles(const vector<string>& paths, vector<Bid>& bids, vector<uint32_t>& rows,
+                           const ViewOrder& order, BidIndex& index, BidColumnStore& columns, ThreadPool& pool,
+                           vector<string>& failed) {
+    vector<string> files = csvFiles(paths);
+    for (const string& file : files) {
+        std::cout << "Loading CSV file " << file << endl;
+    }
+
+    vector<unique_ptr<BidBatch>> batches = readBatches(files, pool);
+    vector<string> read;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (batches[i]) {
+            read.push_back(files[i]);
+        } else {
+            failed.push_back(files[i]);
+        }
+    }
+    size_t first = bids.size();
+    size_t skipped = appendBatches(bids, index, batches);
+
+    // new departments or funds renumber the codes of older bids too
+    if (sortDictionaries(bids)) {
+        columns.updateCodes(bids);
+    }
+    index.append(bids, first);
+    columns.append(bids, first);
+    mergeRows(bids, rows, first, order);
+
+    std::cout << bids.size() - first << " bids added";
+    if (skipped > 0) {
+        std::cout << ", " << skipped << " with an Auction ID already loaded skipped";
+    }
+    std::cout << endl;
+    return read;
+}
+
+/**
+ * Add a bid entered on the console to the table, unless its Auction ID is
+ * already loaded. The view, the indexes and the column store take in the
+ * new row like the rows of an appended file.
+ *
+ * @param bids the bid table
+ * @param rows the view, kept in its order
+ * @param order how the view is ordered
+ * @param index the indexes over the table
+ * @param columns the bid table as columns
+ */
+void enterBid(vector<Bid>& bids, vector<uint32_t>& rows, const ViewOrder& order, BidIndex& index,
+              BidColumnStore& columns) {
+    Bid bid = getBid();
+    if (bid.bidId != Bid::MISSING && index.containsBidId(bid.bidId)) {
+        std::cout << "Auction ID " << bid.bidId << " is already loaded." << endl;
+        return;
+    }
+
+    size_t first = addBid(bids, index, bid);
+    // a new fund renumbers the codes of older bids too
+    if (sortDictionaries(bids)) {
+        columns.updateCodes(bids);
+    }
+    columns.append(bids, first);
+    mergeRows(bids, rows, first, order);
+    std::cout << "Bid added" << endl;
+}
+
+/**
+ * Remove the bids with an Auction ID entered on the console from the
+ * table, the view, the indexes and the column store
+ *
+ * @param bids the bid table
+ * @param rows the view, kept in its order
+ * @param index the indexes over the table
+ * @param columns the bid table as columns
+ */
+void removeBids(vector<Bid>& bids, vector<uint32_t>& rows, BidIndex& index, BidColumnStore& columns) {
+    string value;
+    std::cout << "Auction ID: ";
+    cin >> value;
+
+    long long bidId;
+    if (csv::toInteger(value, bidId) != errc() || bidId < 0 || bidId >= Bid::MISSING) {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        std::cout << "Invalid Auction ID." << endl;
+        return;
+    }
+
+    // an auction paid twice has several rows; removing the last first
+    // leaves the row numbers of the others as found
+    vector<uint32_t> found = index.findBidId(static_cast<uint32_t>(bidId));
+    for (auto row = found.rbegin(); row != found.rend(); ++row) {
+        removeRow(rows, *row);
+        columns.erase(*row);
+        deleteBid(bids, index, *row);
+    }
+    std::cout << found.size() << " bids removed" << endl;
+}
+
+/**
+ * Read a whole line of text, e.g. a department name with spaces
+ */
+static string readText(const char* prompt) {
+    string value;
+    std::cout << prompt;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    getline(cin, value);
+    return value;
+}
+
+/**
+ * Build a filter from conditions entered one by one and display the
+ * matching bids. Conditions are evaluated column by column over the
+ * column store; no bid is copied.
+ *
+ * @param bids the bid table
+ * @param columns the bid table as columns
+ */
+void filterBids(const vector<Bid>& bids, const BidColumnStore& columns) {
+    int combine = 0;
+    std::cout << "Combine conditions with (1. AND, 2. OR): ";
+    cin >> combine;
+    if (!cin || combine < 1 || combine > 2) {
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        std::cout << "Invalid choice." << endl;
+        return;
+    }
+
+    vector<BidFilter> conditions;
+    int condition = -1;
+    while (condition != 0) {
+        std::cout << "Add condition:" << endl;
+        std::cout << " 1. Title starts with" << endl;
+        std::cout << " 2. Title contains" << endl;
+        std::cout << " 3. Department is" << endl;
+        std::cout << " 4. Fund is" << endl;
+        std::cout << " 5. CloseDate between" << endl;
+        std::cout << " 6. WinningBid between" << endl;
+        std::cout << " 7. ArticleID is" << endl;
+        std::cout << " 0. Done" << endl;
+        std::cout << "Enter choice: ";
+        cin >> condition;
+
+        if (!cin) {
+            cin.clear();
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            continue;
+        }
+
+        string low, high;
+        long long lowValue, highValue;
+        int firstDay, lastDay;
+        switch (condition) {
+        case 0:
+            break;
+        case 1:
+            conditions.push_back(BidFilter::titlePrefix(readText("Title starts with: ")));
             break;
         case 2:
-            std::cout << " | ArticleID: " << bids[i].bidId;
+            conditions.push_back(BidFilter::titleContains(readText("Title contains: ")));
             break;
         case 3:
-            std::cout << " | Department: " << bids[i].department;
-            //std::cout << " (Debug: Department field value: " << bids[i].department << ")"; // Debug statement
+            conditions.push_back(BidFilter::equals(eDEPARTMENT, readText("Department: ")));
             break;
         case 4:
-            std::cout << " | CloseDate: " << bids[i].closeDate;
+            conditions.push_back(BidFilter::equals(eFUND, readText("Fund: ")));
             break;
         case 5:
-            std::cout << " | WinningBid: " << bids[i].amount;
-            //std::cout << " (Debug: WinningBid field value: " << bids[i].amount << ")"; // Debug statement
+            std::cout << "From (e.g. 1/1/2014): ";
+            cin >> low;
+            std::cout << "To: ";
+            cin >> high;
+            if (csv::toDate(low, firstDay) == errc() && csv::toDate(high, lastDay) == errc()) {
+                conditions.push_back(BidFilter::between(eCLOSEDATE, firstDay, lastDay));
+            } else {
+                std::cout << "Invalid date." << endl;
+            }
+            break;
         case 6:
-            std::cout << " | InventoryID: " << bids[i].inventoryID;
+            std::cout << "From (e.g. 100.00): ";
+            cin >> low;
+            std::cout << "To: ";
+            cin >> high;
+            if (csv::toCents(low, lowValue) == errc() && csv::toCents(high, highValue) == errc()) {
+                conditions.push_back(BidFilter::between(eAMOUNT, lowValue, highValue));
+            } else {
+                std::cout << "Invalid amount." << endl;
+            }
             break;
         case 7:
-            std::cout << " | VehicleID: " << bids[i].vehicleID;
-            break;
-        case 8:
-            std::cout << " | ReceiptNumber: " << bids[i].receiptNumber;
+            std::cout << "ArticleID: ";
+            cin >> low;
+            if (csv::toInteger(low, lowValue) == errc()) {
+                conditions.push_back(BidFilter::equals(eBIDID, lowValue));
+            } else {
+                std::cout << "Invalid ArticleID." << endl;
+            }
             break;
+        default:
+            std::cout << "Invalid choice. Please enter 0 to 7." << endl;
         }
-        std::cout << std::endl;
     }
-    std::cout << endl;
+
+    BidFilter filter = combine == 1 ? BidFilter::allOf(conditions) : BidFilter::anyOf(conditions);
+    vector<uint32_t> filteredRows = filter.select(columns);
+    std::cout << filteredRows.size() << " bids match" << endl;
+    displayFilteredBids(bids, filteredRows, 9);
 }
 
 /**
- * Simple C function to convert a string to a double
- * after stripping out unwanted char
+ * Wait for Enter before the next page of a listing
  *
- * credit: http://stackoverflow.com/a/24875936
- *
- * @param ch The character to strip out
+ * @param shown rows displayed so far
+ * @param total rows in the listing
+ * @return false to stop the listing
  */
-double strToDouble(string str, char ch) {
-    str.erase(remove(str.begin(), str.end(), ch), str.end());
-    return atof(str.c_str());
+static bool nextPage(size_t shown, size_t total) {
+    string answer;
+    std::cout << "-- " << shown << " of " << total << " bids, Enter for more, q to stop -- " << flush;
+    if (!getline(cin, answer)) {
+        cin.clear();
+        return false;
+    }
+    return answer.empty() || (answer[0] != 'q' && answer[0] != 'Q');
+}
+
+void displayFilteredBids(const vector<Bid>& bids, const vector<uint32_t>& rows, int filterChoice) {
+    OutputWriter out;
+    out << "Displaying filtered bids with additional column\n";
+
+    // the menu choice that led here is still waiting on its line
+    if (pageRows > 0 && rows.size() > pageRows) {
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    }
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (pageRows > 0 && i > 0 && i % pageRows == 0) {
+            out.flush();
+            if (!nextPage(i, rows.size())) {
+                break;
+            }
+        }
+
+        const Bid& bid = bids[rows[i]];
+        displayBid(out, bid);
+
+        // Display additional column based on filterChoice
+        switch (filterChoice) {
+        case 1: 
+            out << " | ArticleTitle: " << text(bid.title);
+            break;
+        case 2:
+            out << " | ArticleID: ";
+            if (bid.bidId != Bid::MISSING) {
+                out << bid.bidId;
+            }
+            break;
+        case 3:
+            out << " | Department: " << bidDepartments.decode(bid.department);
+            //std::cout << " (Debug: Department field value: " << bid.department << ")"; // Debug statement
+            break;
+        case 4:
+            out << " | CloseDate: " << dateText(bid.closeDate);
+            break;
+        case 5:
+            out << " | WinningBid: " << bid.amount / 100.0;
+            //std::cout << " (Debug: WinningBid field value: " << bid.amount << ")"; // Debug statement
+            break;
+        case 6:
+            out << " | InventoryID: " << text(bid.inventoryID);
+            break;
+        case 7:
+            out << " | VehicleID: " << text(bid.vehicleID);
+            break;
+        case 8:
+            out << " | ReceiptNumber: " << text(bid.receiptNumber);
+            break;
+        }
+        out << '\n';
+    }
+    out << '\n';
 }
 
 /**
@@ -477,42 +776,79 @@ double strToDouble(string str, char ch) {
  */
 int main(int argc, char* argv[]) {
 
-    // process command line arguments
+    // process command line arguments: --page N lists bids N at a time,
+    // anything else names CSV files or directories to load
+    vector<string> csvPaths;
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) == "--page" && i + 1 < argc) {
+            pageRows = strtoul(argv[++i], nullptr, 10);
+        } else {
+            csvPaths.push_back(argv[i]);
+        }
+    }
+
+    // console output goes through OutputWriter or std::cout only, never
+    // printf, so iostreams need not keep in step with stdio
+    ios::sync_with_stdio(false);
+
     string csvPath1 = "eBid_Monthly_Sales_Dec_2016.csv";
     string csvPath2 = "eBid_Monthly_Sales.csv";
-    string csvPath;
 
     // Define a vector to hold all the bids
     vector<Bid> bids;
 
+    // CSV files the bids were read from
+    vector<string> loadedFiles;
+
+    // Order the bids are displayed in, sorting only permutes these rows
+    vector<uint32_t> rows;
+    ViewOrder order = { false, eTITLE, false };
+
+    // Lookup and range indexes over the bids, built once they are loaded
+    BidIndex index;
+
+    // The bids one array per column, for the filters
+    BidColumnStore columns;
+
     // Define a timer variable
     clock_t ticks;
 
-    // Initial menu for file selection
-    int fileChoice = 0;
-    while (fileChoice != 1 && fileChoice != 2) {
+    // One thread per hardware thread for the parallel sorts
+    ThreadPool pool;
+
+    // Initial menu for file selection, unless files were named on the
+    // command line
+    int fileChoice = csvPaths.empty() ? 0 : 3;
+    while (fileChoice < 1 || fileChoice > 3) {
         std::cout << "Select file to load:" << endl;
         std::cout << " 1. eBid_Monthly_Sales_Dec_2016.csv" << endl;
         std::cout << " 2. eBid_Monthly_Sales.csv" << endl;
+        std::cout << " 3. Other files or directories" << endl;
         std::cout << "Enter choice: ";
         cin >> fileChoice;
 
         if (fileChoice == 1) {
-            csvPath = csvPath1;
+            csvPaths.push_back(csvPath1);
         }
         else if (fileChoice == 2) {
-            csvPath = csvPath2;
+            csvPaths.push_back(csvPath2);
+        }
+        else if (fileChoice == 3) {
+            csvPaths = readPaths();
         }
         else {
-            std::cout << "Invalid choice. Please enter 1 or 2. " << endl;
+            cin.clear();
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            std::cout << "Invalid choice. Please enter 1, 2 or 3. " << endl;
         }
     }
 
-    std::cout << "Selected file path: " << csvPath << endl;
+    // CSV files named at startup that couldn't be read
+    vector<string> failed;
 
     try { 
         ticks = clock(); 
-        bids = loadBids(csvPath); 
+        loadedFiles = appendFiles(csvPaths, bids, rows, order, index, columns, pool, failed);
         std::cout << bids.size() << " bids read" << endl; 
         ticks = clock() - ticks; 
         std::cout << "time: " << ticks << " clock ticks" << endl; 
@@ -528,15 +864,34 @@ int main(int argc, char* argv[]) {
         cerr << "Unknown error occurred while loading CSV file." << endl;
         return 1; // Exit the program on error
     }
+    // every file asked for has to load, only Append CSV Files goes on
+    // without the ones that fail
+    if (!failed.empty()) {
+        cerr << "Failed to load " << failed.size() << " of " << failed.size() + loadedFiles.size()
+             << " CSV files" << endl;
+        return 1; // Exit the program on error
+    }
+    if (loadedFiles.empty()) {
+        cerr << "No CSV files found" << endl;
+        return 1; // Exit the program on error
+    }
 
     int choice = 0;
-    while (choice != 9) {
+    while (choice != 13) {
         std::cout << "Menu:" << endl;
         std::cout << "  1. Display All Bids" << endl;
         std::cout << "  2. Bid Filtering" << endl;
         std::cout << "  3. Selection Sort All Bids" << endl;
         std::cout << "  4. Quick Sort All Bids" << endl;
-        std::cout << "  9. Exit" << endl;
+        std::cout << "  5. Parallel Sort All Bids" << endl;
+        std::cout << "  6. External Sort File" << endl;
+        std::cout << "  7. Find Bid" << endl;
+        std::cout << "  8. Bids in Amount / Date Range" << endl;
+        std::cout << "  9. Sales Report" << endl;
+        std::cout << "  10. Append CSV Files" << endl;
+        std::cout << "  11. Add Bid" << endl;
+        std::cout << "  12. Remove Bid" << endl;
+        std::cout << "  13. Exit" << endl;
         std::cout << "Enter choice: ";
         cin >> choice;
 
@@ -548,19 +903,20 @@ int main(int argc, char* argv[]) {
                 //displayBid(bids[i]);
             //}
            // std::cout << endl;
-            displayFilteredBids(bids, 0);
+            displayFilteredBids(bids, rows, 0);
             break;
 
         case 2:
             // Call the function to display the filter menu
             //std::cout << "Calling displayFilterMenu" << std::endl; // Debug statement
-            displayFilterMenu(bids);
+            displayFilterMenu(bids, rows, order, columns, pool);
             break;
 
         case 3:
             // Selection sort
             ticks = clock();
-            selectionSort(bids);
+            selectionSort(bids, rows);
+            order = ViewOrder{ true, eTITLE, false };
             ticks = clock() - ticks;
             std::cout << "Selection Sort time: " << ticks << " clock ticks" << endl;
             std::cout << "Selection Sort time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
@@ -569,13 +925,101 @@ int main(int argc, char* argv[]) {
         case 4:
             // Quick sort
             ticks = clock();
-            quickSort(bids, 0, bids.size() - 1);
+            quickSort(bids, rows, 0, rows.size() - 1);
+            order = ViewOrder{ true, eTITLE, false };
             ticks = clock() - ticks;
             std::cout << "Quick Sort time: " << ticks << " clock ticks" << endl;
             std::cout << "Quick Sort time: " << ticks * 1.0 / CLOCKS_PER_SEC << " seconds" << endl;
             break;
 
+        case 5:
+            // Parallel sort, timed on the wall clock since clock() adds up
+            // the time of every thread
+            {
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                parallelSort(bids, rows, pool);
+                order = ViewOrder{ true, eTITLE, false };
+                chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+                std::cout << "Parallel Sort time: " << elapsed.count() << " seconds" << endl;
+                std::cout << "Parallel Sort threads: " << pool.size() << endl;
+            }
+            break;
+
+        case 6:
+            // External sort: the file is sorted on disk in bounded memory,
+            // the loaded bids are not touched
+            {
+                int file = 1;
+                if (loadedFiles.size() > 1) {
+                    for (size_t i = 0; i < loadedFiles.size(); ++i) {
+                        std::cout << " " << i + 1 << ". " << loadedFiles[i] << endl;
+                    }
+                    std::cout << "File to sort: ";
+                    cin >> file;
+                }
+                int column = 0;
+                std::cout << "Sort column (1-9, as in Bid Filtering): ";
+                cin >> column;
+                if (!cin || file < 1 || static_cast<size_t>(file) > loadedFiles.size() || column < 1 || column > 9) {
+                    cin.clear();
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                    std::cout << "Invalid file or column." << endl;
+                    break;
+                }
+                string csvPath = loadedFiles[file - 1];
+                filesystem::path sortedFile = filesystem::path(csvPath).parent_path()
+                    / ("sorted_" + filesystem::path(csvPath).filename().string());
+                string sortedPath = sortedFile.string();
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                try {
+                    externalSort(csvPath, sortedPath, static_cast<SortKey>(column), column == eCLOSEDATE);
+                } catch (exception &e) {
+                    cerr << e.what() << endl;
+                    break;
+                }
+                chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+                std::cout << "Sorted into " << sortedPath << endl;
+                std::cout << "External Sort time: " << elapsed.count() << " seconds" << endl;
+            }
+            break;
+
+        case 7:
+            findBids(bids, index);
+            break;
+
+        case 8:
+            displayIndexRange(bids, index);
+            break;
+
         case 9:
+            displaySalesReport(columns, pool);
+            break;
+
+        case 10:
+            // only the new files are parsed, the view keeps its order
+            {
+                vector<string> paths = readPaths();
+                // files that fail are reported as they are read and left out
+                vector<string> skipped;
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                for (const string& file : appendFiles(paths, bids, rows, order, index, columns, pool, skipped)) {
+                    loadedFiles.push_back(file);
+                }
+                chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+                std::cout << bids.size() << " bids loaded" << endl;
+                std::cout << "Append time: " << elapsed.count() << " seconds" << endl;
+            }
+            break;
+
+        case 11:
+            enterBid(bids, rows, order, index, columns);
+            break;
+
+        case 12:
+            removeBids(bids, rows, index, columns);
+            break;
+
+        case 13:
             std::cout << "Exiting program" << std::endl;
             break;
 